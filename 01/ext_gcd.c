@@ -0,0 +1,154 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_VALUES 1000000
+
+// 2^61 - 1 は素数なので、0 以外のすべての値に逆元が存在します。
+#define MODULUS 2305843009213693951LL
+
+// gcd_iterative.c の gcd を拡張した、拡張ユークリッドの互除法です。
+// gcd(m, n) を返すとともに、m * x + n * y = gcd(m, n) を満たす
+// x, y (Bezout の係数) を *x, *y に格納します。
+// 割り算のたびに、m と n がそれぞれ元の m, n の何倍の和になっているか
+// (x0, y0), (x1, y1) も同じように更新しています。
+int64_t ext_gcd(int64_t m, int64_t n, int64_t* x, int64_t* y) {
+    int64_t x0 = 1, y0 = 0;
+    int64_t x1 = 0, y1 = 1;
+    while (n != 0) {
+        int64_t q = m / n;
+        int64_t r = m - q * n;
+        m = n;
+        n = r;
+
+        int64_t tmp = x0 - q * x1;
+        x0 = x1;
+        x1 = tmp;
+        tmp = y0 - q * y1;
+        y0 = y1;
+        y1 = tmp;
+    }
+    *x = x0;
+    *y = y0;
+    return m;
+}
+
+// a * x ≡ 1 (mod m) となる x を *inverse に格納します。
+// 逆元が存在しない (gcd(a, m) != 1) 場合は false を返します。
+bool mod_inverse(int64_t a, int64_t m, int64_t* inverse) {
+    int64_t x, y;
+    if (ext_gcd(a, m, &x, &y) != 1) {
+        return false;
+    }
+    *inverse = x < 0 ? x + m : x;
+    return true;
+}
+
+int64_t mod_mul(int64_t a, int64_t b, int64_t m) {
+    return (int64_t)((unsigned __int128)a * (unsigned __int128)b % (unsigned __int128)m);
+}
+
+// values の各要素の逆元を inverses に格納します (Montgomery's trick)。
+// 1. prefix[i] = values[0] * ... * values[i] を計算します。 (N 回の乗算)
+// 2. 全体の積 prefix[n - 1] の逆元を拡張ユークリッドの互除法で 1 回だけ求めます。
+// 3. 後ろから順に
+//      inverses[i] = (values[0..i] の積の逆元) * prefix[i - 1]
+//      (values[0..i-1] の積の逆元) = (values[0..i] の積の逆元) * values[i]
+//    と求めていきます。 (2N 回の乗算)
+// どれか 1 つでも逆元が存在しない場合は全体の積にも逆元が存在しないため、
+// false を返します。
+bool batch_mod_inverse(const int64_t* values, int64_t* inverses, int n, int64_t m) {
+    if (n == 0) {
+        return true;
+    }
+
+    // prefix は inverses の領域を借りて計算します。
+    int64_t* prefix = inverses;
+    prefix[0] = values[0];
+    for (int i = 1; i < n; i++) {
+        prefix[i] = mod_mul(prefix[i - 1], values[i], m);
+    }
+
+    int64_t inverse;
+    if (!mod_inverse(prefix[n - 1], m, &inverse)) {
+        return false;
+    }
+
+    for (int i = n - 1; i > 0; i--) {
+        int64_t inverse_i = mod_mul(inverse, prefix[i - 1], m);
+        inverse = mod_mul(inverse, values[i], m);
+        inverses[i] = inverse_i;
+    }
+    inverses[0] = inverse;
+    return true;
+}
+
+// 入力を作るために用意した本題とは関係ない関数です。
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+int main() {
+    // 拡張ユークリッドの互除法
+    int64_t x, y;
+    int64_t g = ext_gcd(240, 46, &x, &y);
+    printf("gcd(240, 46) = %lld = 240 * (%lld) + 46 * (%lld)\n",
+           (long long)g, (long long)x, (long long)y);
+
+    int64_t inverse;
+    mod_inverse(3, 11, &inverse);
+    printf("3^-1 mod 11 = %lld\n", (long long)inverse);
+
+    // 逆元をまとめて求める
+    int64_t* values = (int64_t*)malloc(NUM_VALUES * sizeof(int64_t));
+    int64_t* expected = (int64_t*)malloc(NUM_VALUES * sizeof(int64_t));
+    int64_t* inverses = (int64_t*)malloc(NUM_VALUES * sizeof(int64_t));
+    uint64_t state = 88172645463325252ULL;
+    for (int i = 0; i < NUM_VALUES; i++) {
+        values[i] = (int64_t)(xorshift64(&state) % (MODULUS - 1)) + 1;
+    }
+
+    long start_clock = clock();
+    for (int i = 0; i < NUM_VALUES; i++) {
+        mod_inverse(values[i], MODULUS, &expected[i]);
+    }
+    long end_clock = clock();
+    double single_time = (double)(end_clock - start_clock) / CLOCKS_PER_SEC;
+
+    start_clock = clock();
+    bool ok = batch_mod_inverse(values, inverses, NUM_VALUES, MODULUS);
+    end_clock = clock();
+    double batch_time = (double)(end_clock - start_clock) / CLOCKS_PER_SEC;
+
+    assert(ok);
+    for (int i = 0; i < NUM_VALUES; i++) {
+        assert(inverses[i] == expected[i]);
+        assert(mod_mul(values[i], inverses[i], MODULUS) == 1);
+    }
+
+    printf("values            : %d (mod 2^61 - 1)\n", NUM_VALUES);
+    printf("mod_inverse x N   : %.6lf s (%6.1lf ns/element)\n", single_time, single_time * 1e9 / NUM_VALUES);
+    printf("batch_mod_inverse : %.6lf s (%6.1lf ns/element)\n", batch_time, batch_time * 1e9 / NUM_VALUES);
+
+    free(values);
+    free(expected);
+    free(inverses);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// gcd(240, 46) = 2 = 240 * (-9) + 46 * (47)
+// 3^-1 mod 11 = 4
+// values            : 1000000 (mod 2^61 - 1)
+// mod_inverse x N   : 0.241231 s ( 241.2 ns/element)
+// batch_mod_inverse : 0.022004 s (  22.0 ns/element)
@@ -0,0 +1,452 @@
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86_SIMD 1
+#else
+#define HAS_X86_SIMD 0
+#endif
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_PAIRS 1000000
+
+// gcd_iterative.c と gcd_recursive.c の gcd をそのまま持ってきたものです。
+// 比較の基準として使います。
+int gcd_iterative(int m, int n) {
+    int r;
+    do {
+        r = m % n;
+        m = n;
+        n = r;
+    } while (r != 0);
+    return m;
+}
+
+int gcd_recursive(int m, int n) {
+    if (n == 0) {
+        return m;
+    }
+    return gcd_recursive(n, m % n);
+}
+
+// 上の gcd を 64 bit, 128 bit に広げたものです。
+uint64_t euclid_gcd64(uint64_t m, uint64_t n) {
+    while (n != 0) {
+        uint64_t r = m % n;
+        m = n;
+        n = r;
+    }
+    return m;
+}
+
+unsigned __int128 euclid_gcd128(unsigned __int128 m, unsigned __int128 n) {
+    while (n != 0) {
+        unsigned __int128 r = m % n;
+        m = n;
+        n = r;
+    }
+    return m;
+}
+
+// 割り算を使わない二進 GCD (Stein のアルゴリズム) です。
+// 割り算 (%) は整数演算の中で最も遅い命令のひとつなので、
+// 代わりに末尾の 0 の個数 (ctz) によるシフトと引き算だけで計算します。
+// gcd(a, b) = gcd(|a - b|, min(a, b)) であり、奇数同士の差は偶数なので
+// 差の末尾の 0 を毎回まとめて取り除くことができます。
+uint64_t binary_gcd(uint64_t a, uint64_t b) {
+    if (a == 0) {
+        return b;
+    }
+    if (b == 0) {
+        return a;
+    }
+    int az = __builtin_ctzll(a);
+    int bz = __builtin_ctzll(b);
+    int shift = az < bz ? az : bz;
+    b >>= bz;
+    while (a != 0) {
+        a >>= az;
+        uint64_t diff = b - a;
+        // __builtin_ctzll(0) は未定義なので最上位ビットを立てておきます。
+        // diff == 0 のときは a が 0 になりループを抜けるため az は使われません。
+        // なお、b - a と a - b の末尾の 0 の個数は等しくなります。
+        az = __builtin_ctzll(diff | (1ULL << 63));
+        uint64_t min = a < b ? a : b;
+        a = a < b ? diff : a - b;
+        b = min;
+    }
+    return b << shift;
+}
+
+static int bit_length64(uint64_t x) {
+    return x == 0 ? 0 : 64 - __builtin_clzll(x);
+}
+
+static int bit_length128(unsigned __int128 x) {
+    uint64_t high = (uint64_t)(x >> 64);
+    if (high != 0) {
+        return 64 + bit_length64(high);
+    }
+    return bit_length64((uint64_t)x);
+}
+
+// Lehmer の GCD です (Knuth, TAOCP Vol.2 4.5.2 Algorithm L)。
+// 大きな数の割り算を何度も行う代わりに、上位 p bit だけを取り出した
+// 小さな数 (u_hat, v_hat) でユークリッドの互除法を進め、商が確定している
+// 間の変換行列 [A B; C D] を一度に大きな数へ適用します。
+// 係数は符号付きですが、A*u + B*v の真の値は 0 以上 u 未満に収まるため
+// 2^64 (2^128) を法とした符号なし演算でも正しい結果が得られます。
+// 効果があるのは大きな数の割り算が遅い多倍長 (ここでは 128 bit) の場合です。
+// 64 bit では u % v 自体が 1 命令なので、商 1 つに割り算 2 回を使う
+// lehmer_gcd64 は euclid_gcd64 より遅くなります (実行結果を参照)。
+// そのため lehmer_gcd128 の仕上げにも lehmer_gcd64 ではなく binary_gcd を使います。
+#define LEHMER_BITS64 31
+
+uint64_t lehmer_gcd64(uint64_t u, uint64_t v) {
+    if (u < v) {
+        uint64_t tmp = u;
+        u = v;
+        v = tmp;
+    }
+    while (v >> LEHMER_BITS64 != 0) {
+        int shift = bit_length64(u) - LEHMER_BITS64;
+        int64_t u_hat = (int64_t)(u >> shift);
+        int64_t v_hat = (int64_t)(v >> shift);
+        int64_t a = 1, b = 0, c = 0, d = 1;
+        while (v_hat + c != 0 && v_hat + d != 0) {
+            int64_t q = (u_hat + a) / (v_hat + c);
+            if (q != (u_hat + b) / (v_hat + d)) {
+                break;
+            }
+            int64_t t = a - q * c;
+            a = c;
+            c = t;
+            t = b - q * d;
+            b = d;
+            d = t;
+            t = u_hat - q * v_hat;
+            u_hat = v_hat;
+            v_hat = t;
+        }
+        if (b == 0) {
+            // 上位 bit だけでは商が確定しなかったので 1 回だけ普通に割ります。
+            uint64_t t = u % v;
+            u = v;
+            v = t;
+        } else {
+            uint64_t t = (uint64_t)a * u + (uint64_t)b * v;
+            uint64_t w = (uint64_t)c * u + (uint64_t)d * v;
+            u = t;
+            v = w;
+        }
+    }
+    // 残りは 1 word に収まるので二進 GCD で仕上げます。
+    return binary_gcd(u, v);
+}
+
+#define LEHMER_BITS128 62
+
+unsigned __int128 lehmer_gcd128(unsigned __int128 u, unsigned __int128 v) {
+    if (u < v) {
+        unsigned __int128 tmp = u;
+        u = v;
+        v = tmp;
+    }
+    while (v >> 64 != 0) {
+        int shift = bit_length128(u) - LEHMER_BITS128;
+        int64_t u_hat = (int64_t)(u >> shift);
+        int64_t v_hat = (int64_t)(v >> shift);
+        int64_t a = 1, b = 0, c = 0, d = 1;
+        while (v_hat + c != 0 && v_hat + d != 0) {
+            int64_t q = (u_hat + a) / (v_hat + c);
+            if (q != (u_hat + b) / (v_hat + d)) {
+                break;
+            }
+            int64_t t = a - q * c;
+            a = c;
+            c = t;
+            t = b - q * d;
+            b = d;
+            d = t;
+            t = u_hat - q * v_hat;
+            u_hat = v_hat;
+            v_hat = t;
+        }
+        if (b == 0) {
+            unsigned __int128 t = u % v;
+            u = v;
+            v = t;
+        } else {
+            // 符号付きの係数を符号拡張してから 128 bit で掛けます。
+            unsigned __int128 t = (unsigned __int128)(__int128)a * u + (unsigned __int128)(__int128)b * v;
+            unsigned __int128 w = (unsigned __int128)(__int128)c * u + (unsigned __int128)(__int128)d * v;
+            u = t;
+            v = w;
+        }
+    }
+    // v が 64 bit に収まったら、1 回割って二進 GCD に落とします。
+    if (v == 0) {
+        return u;
+    }
+    return binary_gcd((uint64_t)v, (uint64_t)(u % v));
+}
+
+// 複数の組を同時に進める二進 GCD です。
+// 1 組ずつ計算すると、ctz → シフト → 引き算 の依存関係の鎖が 1 本しかなく
+// CPU の演算器が遊んでしまいます。互いに独立な組を同じループで
+// 1 ステップずつ進めれば、その分だけ並列に計算できるはずです。
+//
+// ただし、スカラーのレーンを並べるだけでは速くなりませんでした。
+// 4 レーン分の状態 (a, b, ctz, shift, 書き込み位置) は汎用レジスタに収まらず
+// 毎ステップ配列を読み書きすることになり、さらに「どのレーンが終わったか」の
+// 分岐は予測が当たらないため、binary_gcd を 1 組ずつ呼ぶより遅くなります
+// (手元では 31 bit で 63 ns/pair 対 48 ns/pair)。
+// そこで、AVX-512 が使える CPU では 1 命令で 8 組を進めます。
+// AVX2 には 64 bit の ctz と符号なし min/max が無いため、AVX-512F と
+// AVX-512CD (64 bit の lzcnt) を使います。使えない CPU では binary_gcd を
+// 1 組ずつ呼びます。
+#define BATCH_GROUP 16
+
+void gcd_batch_scalar(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = binary_gcd(a[i], b[i]);
+    }
+}
+
+#if HAS_X86_SIMD
+// 8 組の ctz を同時に求めます。x & -x で最下位の 1 だけを残し、
+// 63 - lzcnt でその位置を得ます。x は 0 でないものとします。
+__attribute__((target("avx512f,avx512cd"))) static inline __m512i ctz_epi64(__m512i x) {
+    __m512i low = _mm512_and_si512(x, _mm512_sub_epi64(_mm512_setzero_si512(), x));
+    return _mm512_sub_epi64(_mm512_set1_epi64(63), _mm512_lzcnt_epi64(low));
+}
+
+// 16 組 (8 組のベクトル 2 本) を 1 グループとし、全部の組が終わるまで同じ
+// ステップを繰り返します。終わった組はマスクで止めるので分岐はループの
+// 終了判定だけです。2 本のベクトルは互いに独立なので、片方の ctz を待つ
+// 間にもう片方を進められます。
+// 一番遅い組を待つ無駄はありますが、1 命令で 8 組進むのでそれを上回ります。
+__attribute__((target("avx512f,avx512cd"))) void gcd_batch_avx512(const uint64_t* a, const uint64_t* b,
+                                                                   uint64_t* out, size_t n) {
+    const __m512i top = _mm512_set1_epi64((long long)(1ULL << 63));
+    size_t i = 0;
+    for (; i + BATCH_GROUP <= n; i += BATCH_GROUP) {
+        // binary_gcd の a, az, b, shift に対応します。
+        __m512i va[2], vaz[2], vb[2], vshift[2];
+        __mmask8 active[2];
+        for (int k = 0; k < 2; k++) {
+            __m512i x = _mm512_loadu_si512(a + i + 8 * k);
+            __m512i y = _mm512_loadu_si512(b + i + 8 * k);
+            __m512i xz = ctz_epi64(_mm512_or_si512(x, top));
+            __m512i yz = ctz_epi64(_mm512_or_si512(y, top));
+            // どちらかが 0 の組は最初から終わっていて、答えは x | y です。
+            __mmask8 nonzero = _mm512_test_epi64_mask(x, x) & _mm512_test_epi64_mask(y, y);
+            vshift[k] = _mm512_maskz_min_epu64(nonzero, xz, yz);
+            vb[k] = _mm512_mask_srlv_epi64(_mm512_or_si512(x, y), nonzero, y, yz);
+            va[k] = _mm512_maskz_mov_epi64(nonzero, x);
+            vaz[k] = xz;
+            active[k] = nonzero;
+        }
+        while ((active[0] | active[1]) != 0) {
+            for (int k = 0; k < 2; k++) {
+                __m512i x = _mm512_srlv_epi64(va[k], vaz[k]);
+                __m512i min = _mm512_min_epu64(x, vb[k]);
+                __m512i diff = _mm512_sub_epi64(_mm512_max_epu64(x, vb[k]), min);
+                vaz[k] = ctz_epi64(_mm512_or_si512(diff, top));
+                vb[k] = _mm512_mask_mov_epi64(vb[k], active[k], min);
+                va[k] = _mm512_maskz_mov_epi64(active[k], diff);
+                active[k] = _mm512_test_epi64_mask(va[k], va[k]);
+            }
+        }
+        _mm512_storeu_si512(out + i, _mm512_sllv_epi64(vb[0], vshift[0]));
+        _mm512_storeu_si512(out + i + 8, _mm512_sllv_epi64(vb[1], vshift[1]));
+    }
+    // 1 グループに満たない残りは 1 組ずつ計算します。
+    gcd_batch_scalar(a + i, b + i, out + i, n - i);
+}
+#endif
+
+// out[i] = gcd(a[i], b[i]) を n 組まとめて計算します。
+// 実行時に CPUID で CPU が対応している命令を調べて、使う関数を選びます。
+void (*gcd_batch)(const uint64_t* a, const uint64_t* b, uint64_t* out, size_t n) = gcd_batch_scalar;
+const char* gcd_batch_name = "scalar";
+
+void init_gcd_batch() {
+#if HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512cd")) {
+        gcd_batch = gcd_batch_avx512;
+        gcd_batch_name = "avx512";
+        return;
+    }
+#endif
+    gcd_batch = gcd_batch_scalar;
+    gcd_batch_name = "scalar";
+}
+
+// 入力を作るために用意した本題とは関係ない関数です。
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+double elapsed(long start_clock, long end_clock) {
+    return (double)(end_clock - start_clock) / CLOCKS_PER_SEC;
+}
+
+void report(const char* name, double seconds, uint64_t checksum) {
+    printf("%-16s: %.6lf s (%6.1lf ns/pair) checksum %llu\n",
+           name, seconds, seconds * 1e9 / NUM_PAIRS, (unsigned long long)checksum);
+}
+
+int main() {
+    uint64_t* a = (uint64_t*)malloc(NUM_PAIRS * sizeof(uint64_t));
+    uint64_t* b = (uint64_t*)malloc(NUM_PAIRS * sizeof(uint64_t));
+    uint64_t* out = (uint64_t*)malloc(NUM_PAIRS * sizeof(uint64_t));
+    uint64_t state = 88172645463325252ULL;
+    init_gcd_batch();
+    printf("selected kernel: %s\n", gcd_batch_name);
+
+    // 既存の gcd は int なので、まずは 31 bit の正の数で比較します。
+    // 共通の約数を持つように、同じ乱数を掛けた組も混ぜています。
+    // 2^21 * 1023 < 2^31 なので、int に入ります。
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        uint64_t common = xorshift64(&state) % 1023 + 1;
+        a[i] = ((xorshift64(&state) & 0x1fffff) + 1) * common;
+        b[i] = ((xorshift64(&state) & 0x1fffff) + 1) * common;
+    }
+
+    printf("31 bit pairs: %d\n", NUM_PAIRS);
+    uint64_t checksum = 0;
+    long start_clock = clock();
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        checksum += gcd_iterative((int)a[i], (int)b[i]);
+    }
+    report("gcd_iterative", elapsed(start_clock, clock()), checksum);
+
+    checksum = 0;
+    start_clock = clock();
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        checksum += gcd_recursive((int)a[i], (int)b[i]);
+    }
+    report("gcd_recursive", elapsed(start_clock, clock()), checksum);
+
+    checksum = 0;
+    start_clock = clock();
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        checksum += binary_gcd(a[i], b[i]);
+    }
+    report("binary_gcd", elapsed(start_clock, clock()), checksum);
+
+    checksum = 0;
+    start_clock = clock();
+    gcd_batch(a, b, out, NUM_PAIRS);
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        checksum += out[i];
+    }
+    report("gcd_batch", elapsed(start_clock, clock()), checksum);
+
+    // 64 bit の組
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        uint64_t common = (xorshift64(&state) & 0xffff) + 1;
+        a[i] = (xorshift64(&state) >> 17) * common;
+        b[i] = (xorshift64(&state) >> 17) * common;
+    }
+
+    printf("64 bit pairs: %d\n", NUM_PAIRS);
+    uint64_t expected = 0;
+    start_clock = clock();
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        expected += euclid_gcd64(a[i], b[i]);
+    }
+    report("euclid_gcd64", elapsed(start_clock, clock()), expected);
+
+    checksum = 0;
+    start_clock = clock();
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        checksum += binary_gcd(a[i], b[i]);
+    }
+    report("binary_gcd", elapsed(start_clock, clock()), checksum);
+    assert(checksum == expected);
+
+    checksum = 0;
+    start_clock = clock();
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        checksum += lehmer_gcd64(a[i], b[i]);
+    }
+    report("lehmer_gcd64", elapsed(start_clock, clock()), checksum);
+    assert(checksum == expected);
+
+    checksum = 0;
+    start_clock = clock();
+    gcd_batch(a, b, out, NUM_PAIRS);
+    for (int i = 0; i < NUM_PAIRS; i++) {
+        checksum += out[i];
+    }
+    report("gcd_batch", elapsed(start_clock, clock()), checksum);
+    assert(checksum == expected);
+
+    // 128 bit の組 (上位と下位の 64 bit を別々に作ります)
+    int num_pairs128 = NUM_PAIRS / 10;
+    unsigned __int128* x = (unsigned __int128*)malloc(num_pairs128 * sizeof(unsigned __int128));
+    unsigned __int128* y = (unsigned __int128*)malloc(num_pairs128 * sizeof(unsigned __int128));
+    for (int i = 0; i < num_pairs128; i++) {
+        unsigned __int128 common = (xorshift64(&state) & 0xffffffff) + 1;
+        x[i] = ((unsigned __int128)(xorshift64(&state) >> 32) << 64 | xorshift64(&state)) * common;
+        y[i] = ((unsigned __int128)(xorshift64(&state) >> 32) << 64 | xorshift64(&state)) * common;
+    }
+
+    printf("128 bit pairs: %d\n", num_pairs128);
+    unsigned __int128 expected128 = 0;
+    start_clock = clock();
+    for (int i = 0; i < num_pairs128; i++) {
+        expected128 += euclid_gcd128(x[i], y[i]);
+    }
+    printf("%-16s: %.6lf s\n", "euclid_gcd128", elapsed(start_clock, clock()));
+
+    unsigned __int128 checksum128 = 0;
+    start_clock = clock();
+    for (int i = 0; i < num_pairs128; i++) {
+        checksum128 += lehmer_gcd128(x[i], y[i]);
+    }
+    printf("%-16s: %.6lf s\n", "lehmer_gcd128", elapsed(start_clock, clock()));
+    assert(checksum128 == expected128);
+
+    free(x);
+    free(y);
+    free(a);
+    free(b);
+    free(out);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// selected kernel: avx512
+// 31 bit pairs: 1000000
+// gcd_iterative   : 0.068043 s (  68.0 ns/pair) checksum 4607660955
+// gcd_recursive   : 0.072399 s (  72.4 ns/pair) checksum 4607660955
+// binary_gcd      : 0.044533 s (  44.5 ns/pair) checksum 4607660955
+// gcd_batch       : 0.018436 s (  18.4 ns/pair) checksum 4607660955
+// 64 bit pairs: 1000000
+// euclid_gcd64    : 0.179844 s ( 179.8 ns/pair) checksum 485887194861
+// binary_gcd      : 0.077979 s (  78.0 ns/pair) checksum 485887194861
+// lehmer_gcd64    : 0.257551 s ( 257.6 ns/pair) checksum 485887194861
+// gcd_batch       : 0.024814 s (  24.8 ns/pair) checksum 485887194861
+// 128 bit pairs: 100000
+// euclid_gcd128   : 0.057534 s
+// lehmer_gcd128   : 0.049708 s
+//
+// gcd_batch は AVX-512 版が選ばれたときの値です。binary_gcd に比べて
+// 31 bit で約 2.4 倍、64 bit で約 3 倍速くなっています。
+// AVX-512 が無い CPU では binary_gcd を 1 組ずつ呼ぶだけなので binary_gcd と同じ速さです。
+// lehmer_gcd64 は euclid_gcd64 より遅く、64 bit では Lehmer の方法は効きません。
+// 128 bit では割り算 1 回が重いため、lehmer_gcd128 が euclid_gcd128 より速くなります。
@@ -0,0 +1,422 @@
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// gcd_iterative.c などは 1 組ずつ対話的に入力するため、パイプラインでは
+// 使えません。このプログラムはファイルまたは標準入力から大量の組を読み、
+// 1 行に 1 つずつ GCD を出力します。
+//
+// 使い方:
+//   ./a.out -g 1000000 > pairs.txt    # テスト用の入力を作る
+//   ./a.out -g 1000000 -b > pairs.bin # テスト用の入力をバイナリ形式で作る
+//   ./a.out pairs.txt > gcd.txt        # テキスト ("m n" が並んだもの)
+//   cat pairs.txt | ./a.out > gcd.txt  # パイプ
+//   ./a.out -b pairs.bin > gcd.txt     # バイナリ
+// 計測結果は標準エラー出力に表示します。
+//
+// テキスト形式は 0 以上 2^64 未満の 10 進数を空白 (スペース、タブ、改行) で
+// 区切って並べたものです。符号や数字以外の文字を含むもの、2^64 以上の数は
+// エラーとして終了します。
+// バイナリ形式は m, n の順に 8 バイトのリトルエンディアンの符号なし整数を
+// 並べたものです。ヘッダや区切りは無く、1 組が 16 バイトになります。
+
+// 一度に処理する組の数です。
+#define BATCH 65536
+#define READ_BLOCK (1 << 20)
+#define WRITE_BLOCK (1 << 20)
+// 1 つの数値が取り得る最大の文字数 (20 桁 + 区切り) よりも大きくしておきます。
+#define MAX_TOKEN 64
+
+// 割り算を使わない二進 GCD です。詳しくは gcd_batch.c を見てください。
+uint64_t gcd(uint64_t a, uint64_t b) {
+    if (a == 0) {
+        return b;
+    }
+    if (b == 0) {
+        return a;
+    }
+    int az = __builtin_ctzll(a);
+    int bz = __builtin_ctzll(b);
+    int shift = az < bz ? az : bz;
+    b >>= bz;
+    while (a != 0) {
+        a >>= az;
+        uint64_t diff = b - a;
+        az = __builtin_ctzll(diff | (1ULL << 63));
+        uint64_t min = a < b ? a : b;
+        a = a < b ? diff : a - b;
+        b = min;
+    }
+    return b << shift;
+}
+
+// バイナリ形式の 8 バイトとこの CPU の uint64_t を相互に変換します。
+uint64_t little_endian64(uint64_t x) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap64(x);
+#else
+    return x;
+#endif
+}
+
+// 入力は通常のファイルであれば mmap でファイル全体をそのまま読み、
+// パイプなど mmap できないものは READ_BLOCK ずつ read します。
+// どちらの場合も data[begin, end) が未処理のバイト列です。
+typedef struct {
+    int fd;
+    char* data;
+    size_t begin;
+    size_t end;
+    size_t capacity;
+    bool mapped;
+    bool eof;
+} reader;
+
+void open_reader(reader* r, int fd) {
+    r->fd = fd;
+    r->begin = 0;
+    r->end = 0;
+    r->mapped = false;
+    r->eof = false;
+
+    struct stat st;
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void* p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            madvise(p, st.st_size, MADV_SEQUENTIAL);
+            r->data = (char*)p;
+            r->end = st.st_size;
+            r->capacity = st.st_size;
+            r->mapped = true;
+            r->eof = true;
+            return;
+        }
+    }
+
+    r->capacity = READ_BLOCK + MAX_TOKEN;
+    r->data = (char*)malloc(r->capacity);
+}
+
+void close_reader(reader* r) {
+    if (r->mapped) {
+        munmap(r->data, r->capacity);
+    } else {
+        free(r->data);
+    }
+}
+
+// 未処理のバイト列が want バイト以上になるまで読み足します。
+// 足りないまま終端に達した場合は false を返します。
+bool fill(reader* r, size_t want) {
+    while (r->end - r->begin < want) {
+        if (r->eof) {
+            return false;
+        }
+        // 未処理部分を先頭に寄せてから続きを読みます。
+        size_t rest = r->end - r->begin;
+        memmove(r->data, r->data + r->begin, rest);
+        r->begin = 0;
+        r->end = rest;
+        ssize_t n = read(r->fd, r->data + r->end, r->capacity - r->end);
+        if (n <= 0) {
+            r->eof = true;
+        } else {
+            r->end += n;
+        }
+    }
+    return true;
+}
+
+bool is_space(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// 数値として読めないトークンを表示して終了します。
+void invalid_token(const char* token, const char* end, const char* message) {
+    const char* p = token;
+    while (p < end && !is_space(*p) && p - token < MAX_TOKEN) {
+        p++;
+    }
+    fprintf(stderr, "%s: \"%.*s\"\n", message, (int)(p - token), token);
+    exit(1);
+}
+
+// scanf の代わりの手書きの整数パーサです。
+// 空白だけを区切りとみなし、それ以外の文字が含まれていればエラーにします。
+bool parse_uint64(reader* r, uint64_t* value) {
+    if (!r->eof && r->end - r->begin < MAX_TOKEN) {
+        fill(r, MAX_TOKEN);
+    }
+    const char* p = r->data + r->begin;
+    const char* end = r->data + r->end;
+    while (p < end && is_space(*p)) {
+        p++;
+    }
+    if (p == end) {
+        // 区切りだけが続いていた場合は読み足してやり直します。
+        r->begin = r->end;
+        if (r->eof) {
+            return false;
+        }
+        return parse_uint64(r, value);
+    }
+    if (end - p < MAX_TOKEN && !r->eof) {
+        // 数値の途中でバッファが切れないように読み足します。
+        r->begin = p - r->data;
+        return parse_uint64(r, value);
+    }
+    const char* token = p;
+    uint64_t x = 0;
+    // 19 桁までは 2^64 未満に収まるので、桁あふれは 20 桁目から調べます。
+    const char* safe_end = end - token > 19 ? token + 19 : end;
+    while (p < safe_end && (unsigned)(*p - '0') <= 9) {
+        x = x * 10 + (*p - '0');
+        p++;
+    }
+    while (p < end && (unsigned)(*p - '0') <= 9) {
+        unsigned digit = *p - '0';
+        // x * 10 + digit が 2^64 以上になるなら桁あふれです。
+        if (x > (UINT64_MAX - digit) / 10) {
+            invalid_token(token, end, "number too large");
+        }
+        x = x * 10 + digit;
+        p++;
+    }
+    // 数字で始まらないものや、数字の直後に空白以外が続くもの、
+    // MAX_TOKEN 文字を超える (先頭に 0 が並んだ) ものは受け付けません。
+    if (p == token || (p < end && !is_space(*p)) || (p == end && !r->eof)) {
+        invalid_token(token, end, "invalid number");
+    }
+    r->begin = p - r->data;
+    *value = x;
+    return true;
+}
+
+// テキスト形式の組を最大 BATCH 組読み込み、読み込んだ組の数を返します。
+size_t parse_text(reader* r, uint64_t* m, uint64_t* n) {
+    size_t count = 0;
+    while (count < BATCH && parse_uint64(r, &m[count])) {
+        if (!parse_uint64(r, &n[count])) {
+            fprintf(stderr, "odd number of integers in input\n");
+            break;
+        }
+        count++;
+    }
+    return count;
+}
+
+// バイナリ形式の組を最大 BATCH 組読み込み、読み込んだ組の数を返します。
+size_t parse_binary(reader* r, uint64_t* m, uint64_t* n) {
+    size_t count = 0;
+    while (count < BATCH && fill(r, 2 * sizeof(uint64_t))) {
+        memcpy(&m[count], r->data + r->begin, sizeof(uint64_t));
+        memcpy(&n[count], r->data + r->begin + sizeof(uint64_t), sizeof(uint64_t));
+        m[count] = little_endian64(m[count]);
+        n[count] = little_endian64(n[count]);
+        r->begin += 2 * sizeof(uint64_t);
+        count++;
+    }
+    if (count < BATCH && r->end != r->begin) {
+        fprintf(stderr, "truncated binary input: %zu trailing bytes ignored\n", r->end - r->begin);
+    }
+    return count;
+}
+
+// 出力は printf を毎回呼ぶ代わりに 1 つの大きなバッファに書き溜めて、
+// いっぱいになったら write でまとめて書き出します。
+typedef struct {
+    int fd;
+    char* data;
+    size_t length;
+} writer;
+
+void flush(writer* w) {
+    size_t written = 0;
+    while (written < w->length) {
+        ssize_t n = write(w->fd, w->data + written, w->length - written);
+        if (n <= 0) {
+            perror("write");
+            exit(1);
+        }
+        written += n;
+    }
+    w->length = 0;
+}
+
+void write_uint64(writer* w, uint64_t x) {
+    if (w->length + MAX_TOKEN > WRITE_BLOCK) {
+        flush(w);
+    }
+    // 下の桁から逆順に作ってから並べ直します。
+    char digits[24];
+    int len = 0;
+    do {
+        digits[len++] = '0' + x % 10;
+        x /= 10;
+    } while (x != 0);
+    char* p = w->data + w->length;
+    for (int i = 0; i < len; i++) {
+        p[i] = digits[len - 1 - i];
+    }
+    p[len] = '\n';
+    w->length += len + 1;
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// テスト用に count 組のランダムな入力を標準出力に書き出します。
+// binary が true のときはバイナリ形式で書き出します。
+void generate(long count, bool binary) {
+    writer w = {STDOUT_FILENO, (char*)malloc(WRITE_BLOCK), 0};
+    uint64_t state = 88172645463325252ULL;
+    for (long i = 0; i < count; i++) {
+        for (int j = 0; j < 2; j++) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            uint64_t x = (state >> 34) * 6;
+            if (binary) {
+                if (w.length + sizeof(uint64_t) > WRITE_BLOCK) {
+                    flush(&w);
+                }
+                x = little_endian64(x);
+                memcpy(w.data + w.length, &x, sizeof(uint64_t));
+                w.length += sizeof(uint64_t);
+            } else {
+                write_uint64(&w, x);
+                w.data[w.length - 1] = j == 0 ? ' ' : '\n';
+            }
+        }
+    }
+    flush(&w);
+    free(w.data);
+}
+
+int main(int argc, char** argv) {
+    bool binary = false;
+    long num_generated = -1;
+    const char* path = NULL;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-g") == 0 && i + 1 < argc) {
+            num_generated = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0) {
+            binary = true;
+        } else {
+            path = argv[i];
+        }
+    }
+    if (num_generated >= 0) {
+        generate(num_generated, binary);
+        return 0;
+    }
+
+    int fd = STDIN_FILENO;
+    if (path != NULL && strcmp(path, "-") != 0) {
+        fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            perror(path);
+            return 1;
+        }
+    }
+
+    reader r;
+    open_reader(&r, fd);
+    writer w = {STDOUT_FILENO, (char*)malloc(WRITE_BLOCK), 0};
+    uint64_t* m = (uint64_t*)malloc(BATCH * sizeof(uint64_t));
+    uint64_t* n = (uint64_t*)malloc(BATCH * sizeof(uint64_t));
+    uint64_t* result = (uint64_t*)malloc(BATCH * sizeof(uint64_t));
+
+    // 入力の解析・GCD の計算・出力の時間を別々に集計します。
+    double parse_time = 0;
+    double compute_time = 0;
+    double output_time = 0;
+    long total = 0;
+    double start = now();
+    while (true) {
+        double t0 = now();
+        size_t count = binary ? parse_binary(&r, m, n) : parse_text(&r, m, n);
+        double t1 = now();
+        for (size_t i = 0; i < count; i++) {
+            result[i] = gcd(m[i], n[i]);
+        }
+        double t2 = now();
+        for (size_t i = 0; i < count; i++) {
+            write_uint64(&w, result[i]);
+        }
+        double t3 = now();
+
+        parse_time += t1 - t0;
+        compute_time += t2 - t1;
+        output_time += t3 - t2;
+        total += count;
+        if (count < BATCH) {
+            break;
+        }
+    }
+    double t = now();
+    flush(&w);
+    output_time += now() - t;
+    double total_time = now() - start;
+
+    fprintf(stderr, "input  : %s (%s, %s)\n", path != NULL ? path : "stdin",
+            binary ? "binary" : "text", r.mapped ? "mmap" : "read");
+    fprintf(stderr, "pairs  : %ld\n", total);
+    fprintf(stderr, "parse  : %.6lf s\n", parse_time);
+    fprintf(stderr, "compute: %.6lf s\n", compute_time);
+    fprintf(stderr, "output : %.6lf s\n", output_time);
+    fprintf(stderr, "total  : %.6lf s (%.0lf pairs/s)\n", total_time, total / total_time);
+
+    close_reader(&r);
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    free(w.data);
+    free(m);
+    free(n);
+    free(result);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// $ ./a.out -g 3000000 > pairs.txt
+// $ ./a.out -g 3000000 -b > pairs.bin
+// $ ./a.out pairs.txt > gcd.txt
+// input  : pairs.txt (text, mmap)
+// pairs  : 3000000
+// parse  : 0.106558 s
+// compute: 0.171379 s
+// output : 0.030026 s
+// total  : 0.307967 s (9741307 pairs/s)
+// $ cat pairs.txt | ./a.out > gcd.txt
+// input  : stdin (text, read)
+// pairs  : 3000000
+// parse  : 0.110478 s
+// compute: 0.157533 s
+// output : 0.023685 s
+// total  : 0.291701 s (10284514 pairs/s)
+// $ ./a.out -b pairs.bin > gcd.txt
+// input  : pairs.bin (binary, mmap)
+// pairs  : 3000000
+// parse  : 0.010903 s
+// compute: 0.155410 s
+// output : 0.023327 s
+// total  : 0.189644 s (15819143 pairs/s)
+// $ echo "-12 18" | ./a.out
+// invalid number: "-12"
+// $ echo "18446744073709551616 2" | ./a.out
+// number too large: "18446744073709551616"
+//
+// 符号や桁あふれを調べるようにしたため、テキストの解析は以前
+// (数字以外を読み飛ばすだけだったもの) と続けて実行して比べると 1〜2 割遅くなります。
@@ -0,0 +1,227 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_QUERIES 1000000
+// 合成した表の最大要素数です。2^28 要素 (int で 1 GiB) まで計測します。
+#define MAX_SYNTHETIC_LENGTH (1 << 28)
+// 同時に進める探索の数です。
+#define GROUP 16
+
+// binary_search.c の binary_search をそのまま持ってきたものです。
+bool binary_search(int* table, int length, int x) {
+    int low = 0;
+    int high = length - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (x < table[middle]) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return (high > -1) && (x == table[high]);
+}
+
+// 分岐のない二分探索です。
+// base は「x 以下となる最後の要素」の候補の先頭、n は候補の数です。
+// 比較結果で base を進めるかどうかを決めるだけなので、コンパイラは
+// 分岐ではなく条件付き移動 (cmov) を使うことができ、分岐予測の
+// 失敗がなくなります。binary_search と同じく、最後に残った要素が
+// x と等しいかどうかを返します。
+bool binary_search_branchless(const int* table, int length, int x) {
+    if (length == 0) {
+        return false;
+    }
+    const int* base = table;
+    int n = length;
+    while (n > 1) {
+        int half = n / 2;
+        base = (base[half] <= x) ? base + half : base;
+        n -= half;
+    }
+    return *base == x;
+}
+
+// 複数の target をまとめて探索し、結果を results に格納します。
+// 1 つの探索では次に読む table[middle] が今の比較結果に依存するため、
+// 表がキャッシュに乗らない大きさになると、毎回のメモリアクセスを
+// 待つことになります。ここでは GROUP 個の探索を 1 段ずつ同時に進め、
+// 各探索について 2 段先で読む可能性のある 2 箇所を先読み (prefetch) します。
+// 次の段で読む場所は base が決まった時点で 1 箇所に決まり、すぐに読むので、
+// 先読みしても間に合いません。
+// 互いに独立な GROUP 個のメモリアクセスが同時に進むため、待ち時間が重なります。
+// 分岐のない探索では候補の数 n は表の長さだけで決まるので、
+// グループ内のすべての探索で同じ段数になります。
+void binary_search_batch(const int* table, int length, const int* targets, int n, bool* results) {
+    if (length == 0) {
+        for (int i = 0; i < n; i++) {
+            results[i] = false;
+        }
+        return;
+    }
+
+    int i = 0;
+    for (; i + GROUP <= n; i += GROUP) {
+        const int* base[GROUP];
+        for (int g = 0; g < GROUP; g++) {
+            base[g] = table;
+        }
+        int len = length;
+        while (len > 1) {
+            int half = len / 2;
+            int next_half = (len - half) / 2;
+            int next_next_half = (len - half - next_half) / 2;
+            for (int g = 0; g < GROUP; g++) {
+                base[g] = (base[g][half] <= targets[i + g]) ? base[g] + half : base[g];
+                // 次の段で base は base[g] か base[g] + next_half になり、
+                // その次の段ではそこから next_next_half 先を読みます。
+                __builtin_prefetch(base[g] + next_next_half);
+                __builtin_prefetch(base[g] + next_half + next_next_half);
+            }
+            len -= half;
+        }
+        for (int g = 0; g < GROUP; g++) {
+            results[i + g] = *base[g] == targets[i + g];
+        }
+    }
+    for (; i < n; i++) {
+        results[i] = binary_search_branchless(table, length, targets[i]);
+    }
+}
+
+// 入力を作るために用意した本題とは関係ない関数です。
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+int compare_int(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// input_*.txt を読み込みます。二分探索のために読み込んだ後で並べ替えます。
+int* load(const char* path, int* length) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fscanf(fp, "%d", length) != 1) {
+        fclose(fp);
+        return NULL;
+    }
+    int* table = (int*)malloc(*length * sizeof(int));
+    for (int i = 0; i < *length; i++) {
+        if (fscanf(fp, "%d", &table[i]) != 1) {
+            free(table);
+            fclose(fp);
+            return NULL;
+        }
+    }
+    fclose(fp);
+    qsort(table, *length, sizeof(int), compare_int);
+    return table;
+}
+
+double seconds_since(long start_clock) {
+    return (double)(clock() - start_clock) / CLOCKS_PER_SEC;
+}
+
+void benchmark(const char* name, int* table, int length, int* targets, bool* expected, bool* results) {
+    // 半分程度が見つかるように、表の最大値の 2 倍までの範囲から選びます。
+    uint64_t state = 88172645463325252ULL;
+    uint64_t range = (uint64_t)table[length - 1] * 2 + 2;
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        targets[i] = (int)(xorshift64(&state) % range);
+    }
+
+    long start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        expected[i] = binary_search(table, length, targets[i]);
+    }
+    double plain = seconds_since(start_clock);
+
+    start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        results[i] = binary_search_branchless(table, length, targets[i]);
+    }
+    double branchless = seconds_since(start_clock);
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        assert(results[i] == expected[i]);
+    }
+
+    start_clock = clock();
+    binary_search_batch(table, length, targets, NUM_QUERIES, results);
+    double batch = seconds_since(start_clock);
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        assert(results[i] == expected[i]);
+    }
+
+    printf("%-20s %10d %12.0lf %12.0lf %12.0lf\n", name, length,
+           NUM_QUERIES / plain, NUM_QUERIES / branchless, NUM_QUERIES / batch);
+}
+
+int main(int argc, char** argv) {
+    int* targets = (int*)malloc(NUM_QUERIES * sizeof(int));
+    bool* expected = (bool*)malloc(NUM_QUERIES * sizeof(bool));
+    bool* results = (bool*)malloc(NUM_QUERIES * sizeof(bool));
+
+    printf("%-20s %10s %12s %12s %12s\n", "table", "length", "plain q/s", "branchless", "batch");
+
+    // 引数で渡された input_*.txt
+    for (int i = 1; i < argc; i++) {
+        int length;
+        int* table = load(argv[i], &length);
+        if (table == NULL) {
+            printf("%s: failed to load\n", argv[i]);
+            continue;
+        }
+        benchmark(argv[i], table, length, targets, expected, results);
+        free(table);
+    }
+
+    // 合成した表 (0, 2, 4, ...)
+    for (long long size = 1 << 16; size <= MAX_SYNTHETIC_LENGTH; size <<= 4) {
+        int length = (int)size;
+        int* table = (int*)malloc((size_t)length * sizeof(int));
+        if (table == NULL) {
+            printf("failed to allocate %d elements\n", length);
+            break;
+        }
+        for (int i = 0; i < length; i++) {
+            table[i] = i * 2;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "synthetic %dKiB", (int)((size_t)length * sizeof(int) >> 10));
+        benchmark(name, table, length, targets, expected, results);
+        free(table);
+    }
+
+    free(targets);
+    free(expected);
+    free(results);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// $ ./a.out input_64.txt input_1024.txt input_4096.txt input_65536.txt
+// table                    length    plain q/s   branchless        batch
+// input_64.txt                 64     34657240    100310964    100684656
+// input_1024.txt             1024     20399837     61946354     63840654
+// input_4096.txt             4096     17093141     47596383     51506567
+// input_65536.txt           65536     11287956     24280095     35399483
+// synthetic 256KiB          65536     11140572     23978515     35330695
+// synthetic 4096KiB       1048576      6022935      6829715     17673465
+// synthetic 65536KiB     16777216      2728721      1986362      8338058
+// synthetic 1048576KiB  268435456      1271660       818980      3686310
@@ -0,0 +1,478 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86_SIMD 1
+#else
+#define HAS_X86_SIMD 0
+#endif
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_QUERIES 1000000
+#define SYNTHETIC_LENGTH 100000000
+
+// 1 つのブロックに入れるキーの数です。
+#define BLOCK 128
+
+// binary_search.c の binary_search をそのまま持ってきたものです。
+bool binary_search(int* table, int length, int x) {
+    int low = 0;
+    int high = length - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (x < table[middle]) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return (high > -1) && (x == table[high]);
+}
+
+// 圧縮した昇順の表です。
+// 表を BLOCK 個ずつのブロックに分け、ブロックごとに先頭のキーと、
+// 隣り合うキーの差 (delta) を保存します。昇順の表では差は元の値より
+// ずっと小さいので、ブロック内の最大の差が収まるビット数 (bit width)
+// だけを使って詰めて (bit-packing) 保存します。
+//
+// ブロック内の差は SIMD でまとめて取り出せるように、4 個ずつ組にして
+// 並べます。i 番目の差は i % 4 番目のレーンに入り、各レーンの中では
+// 32 個の差を下位ビットから順に詰めます。1 ブロックの大きさは
+// ちょうど bit width * 16 byte になります。
+typedef struct {
+    int length;
+    int num_blocks;
+    // ブロックを二分探索するための、各ブロックの先頭のキーだけを並べた配列です。
+    int* first_keys;
+    // ブロックのヘッダです。payload の何番目の 16 byte から始まるかと bit width です。
+    uint32_t* offsets;
+    uint8_t* bits;
+    uint32_t* payload;
+    size_t payload_words;
+} compressed_table;
+
+static inline int bit_width(uint32_t x) {
+    return x == 0 ? 0 : 32 - __builtin_clz(x);
+}
+
+void build(compressed_table* c, const int* sorted, int length) {
+    c->length = length;
+    c->num_blocks = (length + BLOCK - 1) / BLOCK;
+    c->first_keys = (int*)malloc((size_t)c->num_blocks * sizeof(int));
+    c->offsets = (uint32_t*)malloc((size_t)c->num_blocks * sizeof(uint32_t));
+    c->bits = (uint8_t*)malloc((size_t)c->num_blocks);
+
+    // 1. 各ブロックの bit width を求めて、payload の大きさを決めます。
+    size_t words = 0;
+    for (int b = 0; b < c->num_blocks; b++) {
+        int start = b * BLOCK;
+        int end = start + BLOCK < length ? start + BLOCK : length;
+        uint32_t max_delta = 0;
+        for (int i = start + 1; i < end; i++) {
+            uint32_t delta = (uint32_t)sorted[i] - (uint32_t)sorted[i - 1];
+            max_delta = delta > max_delta ? delta : max_delta;
+        }
+        c->first_keys[b] = sorted[start];
+        c->offsets[b] = (uint32_t)(words / 4);
+        c->bits[b] = (uint8_t)bit_width(max_delta);
+        words += (size_t)c->bits[b] * 4;
+    }
+    c->payload_words = words;
+    c->payload = (uint32_t*)aligned_alloc(16, (words + 4) * sizeof(uint32_t));
+    memset(c->payload, 0, (words + 4) * sizeof(uint32_t));
+
+    // 2. 差を詰めていきます。最後のブロックの足りない分は差 0 とします。
+    for (int b = 0; b < c->num_blocks; b++) {
+        int start = b * BLOCK;
+        int bits = c->bits[b];
+        uint32_t* out = c->payload + (size_t)c->offsets[b] * 4;
+        for (int i = 1; i < BLOCK && start + i < length; i++) {
+            uint32_t delta = (uint32_t)sorted[start + i] - (uint32_t)sorted[start + i - 1];
+            int lane = i % 4;
+            int position = i / 4 * bits;
+            int word = position / 32;
+            int shift = position % 32;
+            out[word * 4 + lane] |= delta << shift;
+            if (shift + bits > 32) {
+                out[(word + 1) * 4 + lane] |= delta >> (32 - shift);
+            }
+        }
+    }
+}
+
+void destroy(compressed_table* c) {
+    free(c->first_keys);
+    free(c->offsets);
+    free(c->bits);
+    free(c->payload);
+}
+
+size_t compressed_bytes(const compressed_table* c) {
+    return (size_t)c->num_blocks * (sizeof(int) + sizeof(uint32_t) + sizeof(uint8_t)) +
+           c->payload_words * sizeof(uint32_t);
+}
+
+// ブロック b のキーを out[0 .. BLOCK) に復元します。
+void decode_block_scalar(const compressed_table* c, int b, int* out) {
+    int bits = c->bits[b];
+    const uint32_t* in = c->payload + (size_t)c->offsets[b] * 4;
+    uint32_t mask = bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1;
+    uint32_t key = (uint32_t)c->first_keys[b];
+    for (int i = 0; i < BLOCK; i++) {
+        uint32_t delta = 0;
+        if (bits != 0 && i != 0) {
+            int lane = i % 4;
+            int position = i / 4 * bits;
+            int word = position / 32;
+            int shift = position % 32;
+            delta = in[word * 4 + lane] >> shift;
+            if (shift + bits > 32) {
+                delta |= in[(word + 1) * 4 + lane] << (32 - shift);
+            }
+        }
+        key += delta & mask;
+        out[i] = (int)key;
+    }
+}
+
+#if HAS_X86_SIMD
+// SSE2 版です。1 回のループで 4 個の差を取り出し、
+// 4 個の中での累積和 (prefix sum) をシフトと加算 2 回で求めます。
+__attribute__((target("sse2"))) void decode_block_sse2(const compressed_table* c, int b, int* out) {
+    int bits = c->bits[b];
+    const __m128i* in = (const __m128i*)(c->payload + (size_t)c->offsets[b] * 4);
+    __m128i base = _mm_set1_epi32(c->first_keys[b]);
+    if (bits == 0) {
+        for (int i = 0; i < BLOCK; i += 4) {
+            _mm_storeu_si128((__m128i*)(out + i), base);
+        }
+        return;
+    }
+    __m128i mask = _mm_set1_epi32(bits == 32 ? -1 : (int)((1u << bits) - 1));
+    for (int row = 0; row < BLOCK / 4; row++) {
+        int position = row * bits;
+        int word = position / 32;
+        int shift = position % 32;
+        __m128i delta = _mm_srl_epi32(_mm_load_si128(in + word), _mm_cvtsi32_si128(shift));
+        if (shift + bits > 32) {
+            delta = _mm_or_si128(delta, _mm_sll_epi32(_mm_load_si128(in + word + 1),
+                                                      _mm_cvtsi32_si128(32 - shift)));
+        }
+        delta = _mm_and_si128(delta, mask);
+        // [d0, d1, d2, d3] -> [d0, d0+d1, d0+d1+d2, d0+d1+d2+d3]
+        delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 4));
+        delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 8));
+        __m128i keys = _mm_add_epi32(delta, base);
+        _mm_storeu_si128((__m128i*)(out + row * 4), keys);
+        // 最後のキーを次の 4 個の基準にします。
+        base = _mm_shuffle_epi32(keys, 0xFF);
+    }
+}
+#endif
+
+static inline void decode_block(const compressed_table* c, int b, int* out) {
+#if HAS_X86_SIMD
+    decode_block_sse2(c, b, out);
+#else
+    decode_block_scalar(c, b, out);
+#endif
+}
+
+// ブロック b の中で x より小さいキーの数を返します。
+// ブロック全体を復元してから数えるのではなく、4 個ずつ復元しながら比較し、
+// x 以上のキーが現れたところで止めます。そのキーを *next に返します。
+// 最後のブロックの足りない分は最後のキーと同じ値なので、数えた後で
+// 有効なキーの数 valid で抑えます。
+int rank_in_block_scalar(const compressed_table* c, int b, int x, int valid, int* next) {
+    int keys[BLOCK];
+    decode_block_scalar(c, b, keys);
+    int count = 0;
+    while (count < valid && keys[count] < x) {
+        count++;
+    }
+    *next = keys[count < valid ? count : valid - 1];
+    return count;
+}
+
+#if HAS_X86_SIMD
+__attribute__((target("sse2"))) int rank_in_block_sse2(const compressed_table* c, int b, int x, int valid,
+                                                       int* next) {
+    int bits = c->bits[b];
+    const __m128i* in = (const __m128i*)(c->payload + (size_t)c->offsets[b] * 4);
+    __m128i base = _mm_set1_epi32(c->first_keys[b]);
+    __m128i target = _mm_set1_epi32(x);
+    __m128i mask = _mm_set1_epi32(bits == 32 ? -1 : (int)((1u << bits) - 1));
+    int count = 0;
+    for (int row = 0; row < BLOCK / 4; row++) {
+        __m128i keys = base;
+        if (bits != 0) {
+            int position = row * bits;
+            int word = position / 32;
+            int shift = position % 32;
+            __m128i delta = _mm_srl_epi32(_mm_load_si128(in + word), _mm_cvtsi32_si128(shift));
+            if (shift + bits > 32) {
+                delta = _mm_or_si128(delta, _mm_sll_epi32(_mm_load_si128(in + word + 1),
+                                                          _mm_cvtsi32_si128(32 - shift)));
+            }
+            delta = _mm_and_si128(delta, mask);
+            delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 4));
+            delta = _mm_add_epi32(delta, _mm_slli_si128(delta, 8));
+            keys = _mm_add_epi32(delta, base);
+        }
+        // 昇順なので、x より小さいキーは下位のレーンから連続して並びます。
+        int less = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmplt_epi32(keys, target)));
+        int n = __builtin_popcount(less);
+        count += n;
+        if (n < 4) {
+            int lanes[4];
+            _mm_storeu_si128((__m128i*)lanes, keys);
+            *next = lanes[n];
+            return count;
+        }
+        base = _mm_shuffle_epi32(keys, 0xFF);
+    }
+    *next = _mm_cvtsi128_si32(base);
+    return count < valid ? count : valid;
+}
+#endif
+
+// x 以上となる最初の要素の位置を返します。該当する要素が無い場合は length を返します。
+// 1. ヘッダを二分探索して、先頭のキーが x より小さい最後のブロックを探す
+// 2. そのブロックだけを復元して、x より小さいキーを数える
+// x 以上となる最初の要素は、そのブロックの中か次のブロックの先頭にあります。
+// found が NULL でなければ、x が表に含まれるかどうかも返します。
+int compressed_lower_bound(const compressed_table* c, int x, bool* found) {
+    int low = 0;
+    int high = c->num_blocks;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (c->first_keys[middle] < x) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    int b = low - 1;
+    if (b < 0) {
+        if (found != NULL) {
+            *found = c->length > 0 && c->first_keys[0] == x;
+        }
+        return 0;
+    }
+
+    int start = b * BLOCK;
+    int valid = c->length - start < BLOCK ? c->length - start : BLOCK;
+    int next;
+#if HAS_X86_SIMD
+    int count = rank_in_block_sse2(c, b, x, valid, &next);
+#else
+    int count = rank_in_block_scalar(c, b, x, valid, &next);
+#endif
+    if (found != NULL) {
+        if (count < valid) {
+            *found = next == x;
+        } else {
+            *found = b + 1 < c->num_blocks && c->first_keys[b + 1] == x;
+        }
+    }
+    return start + count;
+}
+
+// binary_search と同じく、x が表に含まれるかどうかを返します。
+bool compressed_search(const compressed_table* c, int x) {
+    bool found;
+    compressed_lower_bound(c, x, &found);
+    return found;
+}
+
+// 比較用の、昇順の表に対する lower bound です。
+int lower_bound(const int* table, int length, int x) {
+    int low = 0;
+    int high = length;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (table[middle] < x) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// 入力を作るために用意した本題とは関係ない関数です。
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+int compare_int(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// input_*.txt を読み込みます。二分探索のために読み込んだ後で並べ替えます。
+int* load(const char* path, int* length) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fscanf(fp, "%d", length) != 1) {
+        fclose(fp);
+        return NULL;
+    }
+    int* table = (int*)malloc(*length * sizeof(int));
+    for (int i = 0; i < *length; i++) {
+        if (fscanf(fp, "%d", &table[i]) != 1) {
+            free(table);
+            fclose(fp);
+            return NULL;
+        }
+    }
+    fclose(fp);
+    qsort(table, *length, sizeof(int), compare_int);
+    return table;
+}
+
+double seconds_since(long start_clock) {
+    return (double)(clock() - start_clock) / CLOCKS_PER_SEC;
+}
+
+void benchmark(const char* name, int* table, int length, int* targets, bool* found, int* ranks) {
+    compressed_table c;
+    build(&c, table, length);
+
+    // 半分は表の中の key、残りは表の範囲内のランダムな値にします。
+    uint64_t state = 88172645463325252ULL;
+    int64_t min_key = table[0];
+    int64_t range = (int64_t)table[length - 1] - min_key + 2;
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        uint64_t r = xorshift64(&state);
+        targets[i] = (r & 1) ? table[(r >> 1) % length] : (int)(min_key - 1 + (int64_t)((r >> 1) % range));
+    }
+
+    long start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        found[i] = binary_search(table, length, targets[i]);
+    }
+    double sorted_search = seconds_since(start_clock) * 1e9 / NUM_QUERIES;
+
+    start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        ranks[i] = lower_bound(table, length, targets[i]);
+    }
+    double sorted_lower_bound = seconds_since(start_clock) * 1e9 / NUM_QUERIES;
+
+    int num_mismatches = 0;
+    start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        num_mismatches += compressed_search(&c, targets[i]) != found[i];
+    }
+    double compressed_search_time = seconds_since(start_clock) * 1e9 / NUM_QUERIES;
+
+    start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        num_mismatches += compressed_lower_bound(&c, targets[i], NULL) != ranks[i];
+    }
+    double compressed_lower_bound_time = seconds_since(start_clock) * 1e9 / NUM_QUERIES;
+    assert(num_mismatches == 0);
+
+    printf("%-18s %10d %6.2lf %6.2lf %9.1lf %9.1lf %9.1lf %9.1lf\n", name, length,
+           (double)sizeof(int), (double)compressed_bytes(&c) / length,
+           sorted_search, compressed_search_time, sorted_lower_bound, compressed_lower_bound_time);
+    destroy(&c);
+}
+
+int main(int argc, char** argv) {
+    int* targets = (int*)malloc(NUM_QUERIES * sizeof(int));
+    bool* found = (bool*)malloc(NUM_QUERIES * sizeof(bool));
+    int* ranks = (int*)malloc(NUM_QUERIES * sizeof(int));
+
+    // 小さな例で圧縮と復元を確認します。
+    int example[BLOCK + 3];
+    for (int i = 0; i < BLOCK + 3; i++) {
+        example[i] = 1000 + i * 3 + i % 2;
+    }
+    compressed_table c;
+    build(&c, example, BLOCK + 3);
+    printf("BLOCKS: %d, bits: [ ", c.num_blocks);
+    for (int b = 0; b < c.num_blocks; b++) {
+        printf("%d ", c.bits[b]);
+    }
+    printf("], %zu bytes\n", compressed_bytes(&c));
+    int decoded[BLOCK];
+    int decoded_scalar[BLOCK];
+    decode_block(&c, 0, decoded);
+    decode_block_scalar(&c, 0, decoded_scalar);
+    assert(memcmp(decoded, example, sizeof(decoded)) == 0);
+    assert(memcmp(decoded, decoded_scalar, sizeof(decoded)) == 0);
+    printf("lower_bound(1010) = %d, search(1388) = %s, search(1389) = %s\n",
+           compressed_lower_bound(&c, 1010, NULL), compressed_search(&c, 1388) ? "Yes" : "No",
+           compressed_search(&c, 1389) ? "Yes" : "No");
+    destroy(&c);
+
+    printf("%-18s %10s %6s %6s %9s %9s %9s %9s\n", "table", "length", "B/key", "comp",
+           "search", "comp", "lb", "comp lb");
+
+    // 引数で渡された input_*.txt
+    for (int i = 1; i < argc; i++) {
+        int length;
+        int* table = load(argv[i], &length);
+        if (table == NULL) {
+            printf("%s: failed to load\n", argv[i]);
+            continue;
+        }
+        benchmark(argv[i], table, length, targets, found, ranks);
+        free(table);
+    }
+
+    // 合成した表: 差が 1 〜 max_gap の一様乱数となるように並べたもの
+    int max_gaps[] = {4, 20, 1000};
+    const char* names[] = {"dense (gap <= 4)", "gap <= 20", "sparse (gap<=1000)"};
+    int* table = (int*)malloc((size_t)SYNTHETIC_LENGTH * sizeof(int));
+    for (int g = 0; g < 3; g++) {
+        uint64_t state = 2463534242ULL;
+        int length = SYNTHETIC_LENGTH;
+        int64_t key = 0;
+        for (int i = 0; i < SYNTHETIC_LENGTH; i++) {
+            key += 1 + (int64_t)(xorshift64(&state) % max_gaps[g]);
+            if (key > 0x7FFFFFFF) {
+                length = i;
+                break;
+            }
+            table[i] = (int)key;
+        }
+        benchmark(names[g], table, length, targets, found, ranks);
+    }
+    free(table);
+
+    free(targets);
+    free(found);
+    free(ranks);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// $ ./a.out input_64.txt input_1024.txt input_4096.txt input_65536.txt
+// BLOCKS: 2, bits: [ 3 3 ], 114 bytes
+// lower_bound(1010) = 3, search(1388) = Yes, search(1389) = No
+// table                  length  B/key   comp    search      comp        lb   comp lb
+// input_64.txt               64   4.00   0.39      43.5      61.2      50.5      63.2
+// input_1024.txt           1024   4.00   0.20      70.6     124.1      74.2     122.7
+// input_4096.txt           4096   4.00   0.20      80.0     152.1      87.7     172.4
+// input_65536.txt         65536   4.00   0.20     149.2     216.6     156.9     218.2
+// dense (gap <= 4)    100000000   4.00   0.45     878.2     729.5     899.7     729.5
+// gap <= 20           100000000   4.00   0.70     890.1     734.6     909.5     718.0
+// sparse (gap<=1000)    4291926   4.00   1.32     328.4     265.1     310.0     283.9
@@ -0,0 +1,268 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_QUERIES 1000000
+// 合成した表の最大要素数です。LLC を超える大きさまで計測します。
+#define MAX_SYNTHETIC_LENGTH (1 << 28)
+
+// binary_search.c の binary_search をそのまま持ってきたものです。
+bool binary_search(int* table, int length, int x) {
+    int low = 0;
+    int high = length - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (x < table[middle]) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return (high > -1) && (x == table[high]);
+}
+
+// Eytzinger 配置 (BFS 順) の表です。
+// 昇順の表を二分探索木とみなし、その木を根から幅優先に並べ直します。
+// keys[1] が根、keys[k] の子が keys[2k] と keys[2k + 1] です (keys[0] は使いません)。
+// 二分探索で最初の数回に読む要素が配列の先頭にまとまるためキャッシュに残りやすく、
+// また子孫がまとまって並ぶため数段先の要素を先読みできます。
+// rank[k] は keys[k] が元の昇順の表で何番目だったかを表します。
+typedef struct {
+    int length;
+    int* keys;
+    int* rank;
+} eytzinger;
+
+// 木の中間順 (in-order) に昇順の表の要素を順番に置いていきます。
+int build_recursive(eytzinger* e, const int* sorted, int i, int k) {
+    if (k <= e->length) {
+        i = build_recursive(e, sorted, i, 2 * k);
+        e->keys[k] = sorted[i];
+        e->rank[k] = i;
+        i++;
+        i = build_recursive(e, sorted, i, 2 * k + 1);
+    }
+    return i;
+}
+
+void build(eytzinger* e, const int* sorted, int length) {
+    e->length = length;
+    // 64 byte 境界に揃えると、keys[16k .. 16k + 15] (k の 4 段下の子孫) が
+    // ちょうど 1 本のキャッシュラインに収まります。
+    size_t size = ((size_t)(length + 1) * sizeof(int) + 63) / 64 * 64;
+    e->keys = (int*)aligned_alloc(64, size);
+    e->rank = (int*)malloc((size_t)(length + 1) * sizeof(int));
+    build_recursive(e, sorted, 0, 1);
+}
+
+void destroy(eytzinger* e) {
+    free(e->keys);
+    free(e->rank);
+}
+
+// x 以上となる最初の要素の Eytzinger 配置での位置を返します。
+// 該当する要素が無い場合は 0 を返します。
+// 木を下る間の比較結果を k の下位ビットに記録していき、最後に
+// 「最後に右に進んだ位置」まで戻ることで lower bound を得ます。
+// 比較結果はそのまま k に足すだけなので分岐はありません。
+int lower_bound_index(const eytzinger* e, int x) {
+    int k = 1;
+    while (k <= e->length) {
+        // 4 段先 (16 個の子孫) は 1 本のキャッシュラインに収まるので、
+        // 今のうちにまとめて読み込みを始めておきます。
+        __builtin_prefetch(e->keys + (size_t)k * 16);
+        k = 2 * k + (e->keys[k] < x);
+    }
+    // 末尾に続く 1 (右に進んだ回数) と、その上の 0 を 1 つ取り除きます。
+    k >>= __builtin_ffs(~k);
+    return k;
+}
+
+// x 以上となる最初の要素の、元の昇順の表での位置を返します。
+// 該当する要素が無い場合は length を返します。
+int eytzinger_lower_bound(const eytzinger* e, int x) {
+    int k = lower_bound_index(e, x);
+    return k == 0 ? e->length : e->rank[k];
+}
+
+// binary_search と同じく、x が表に含まれるかどうかを返します。
+bool eytzinger_search(const eytzinger* e, int x) {
+    int k = lower_bound_index(e, x);
+    return k != 0 && e->keys[k] == x;
+}
+
+// 比較用の、昇順の表に対する lower bound です。
+int lower_bound(const int* table, int length, int x) {
+    int low = 0;
+    int high = length;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (table[middle] < x) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// 入力を作るために用意した本題とは関係ない関数です。
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+int compare_int(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// input_*.txt を読み込みます。二分探索のために読み込んだ後で並べ替えます。
+int* load(const char* path, int* length) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fscanf(fp, "%d", length) != 1) {
+        fclose(fp);
+        return NULL;
+    }
+    int* table = (int*)malloc(*length * sizeof(int));
+    for (int i = 0; i < *length; i++) {
+        if (fscanf(fp, "%d", &table[i]) != 1) {
+            free(table);
+            fclose(fp);
+            return NULL;
+        }
+    }
+    fclose(fp);
+    qsort(table, *length, sizeof(int), compare_int);
+    return table;
+}
+
+double seconds_since(long start_clock) {
+    return (double)(clock() - start_clock) / CLOCKS_PER_SEC;
+}
+
+void benchmark(const char* name, int* table, int length, int* targets, bool* found, int* ranks) {
+    eytzinger e;
+    build(&e, table, length);
+
+    // 半分程度が見つかるように、表の最大値の 2 倍までの範囲から選びます。
+    uint64_t state = 88172645463325252ULL;
+    uint64_t range = (uint64_t)table[length - 1] * 2 + 2;
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        targets[i] = (int)(xorshift64(&state) % range);
+    }
+
+    long start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        found[i] = binary_search(table, length, targets[i]);
+    }
+    double sorted_search = seconds_since(start_clock);
+
+    start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        ranks[i] = lower_bound(table, length, targets[i]);
+    }
+    double sorted_lower_bound = seconds_since(start_clock);
+
+    int num_mismatches = 0;
+    start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        num_mismatches += eytzinger_search(&e, targets[i]) != found[i];
+    }
+    double eytzinger_time = seconds_since(start_clock);
+
+    start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        num_mismatches += eytzinger_lower_bound(&e, targets[i]) != ranks[i];
+    }
+    double eytzinger_lower_bound_time = seconds_since(start_clock);
+    assert(num_mismatches == 0);
+
+    printf("%-20s %10d %12.0lf %12.0lf %12.0lf %12.0lf\n", name, length,
+           NUM_QUERIES / sorted_search, NUM_QUERIES / eytzinger_time,
+           NUM_QUERIES / sorted_lower_bound, NUM_QUERIES / eytzinger_lower_bound_time);
+    destroy(&e);
+}
+
+int main(int argc, char** argv) {
+    int* targets = (int*)malloc(NUM_QUERIES * sizeof(int));
+    bool* found = (bool*)malloc(NUM_QUERIES * sizeof(bool));
+    int* ranks = (int*)malloc(NUM_QUERIES * sizeof(int));
+
+    // 小さな例で並び方を確認します。
+    int example[] = {1, 3, 3, 5, 9, 12, 20};
+    eytzinger e;
+    build(&e, example, 7);
+    printf("EYTZINGER: [ ");
+    for (int k = 1; k <= e.length; k++) {
+        printf("%d ", e.keys[k]);
+    }
+    printf("]\n");
+    printf("lower_bound(4) = %d, search(5) = %s, search(8) = %s\n",
+           eytzinger_lower_bound(&e, 4), eytzinger_search(&e, 5) ? "Yes" : "No",
+           eytzinger_search(&e, 8) ? "Yes" : "No");
+    destroy(&e);
+
+    printf("%-20s %10s %12s %12s %12s %12s\n", "table", "length", "sorted q/s", "eytzinger",
+           "sorted lb", "eytzinger lb");
+
+    // 引数で渡された input_*.txt
+    for (int i = 1; i < argc; i++) {
+        int length;
+        int* table = load(argv[i], &length);
+        if (table == NULL) {
+            printf("%s: failed to load\n", argv[i]);
+            continue;
+        }
+        benchmark(argv[i], table, length, targets, found, ranks);
+        free(table);
+    }
+
+    // 合成した表 (0, 2, 4, ...)
+    for (long long size = 1 << 16; size <= MAX_SYNTHETIC_LENGTH; size <<= 2) {
+        int length = (int)size;
+        int* table = (int*)malloc((size_t)length * sizeof(int));
+        for (int i = 0; i < length; i++) {
+            table[i] = i * 2;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "synthetic %dKiB", (int)((size_t)length * sizeof(int) >> 10));
+        benchmark(name, table, length, targets, found, ranks);
+        free(table);
+    }
+
+    free(targets);
+    free(found);
+    free(ranks);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// $ ./a.out input_64.txt input_1024.txt input_4096.txt input_65536.txt
+// EYTZINGER: [ 5 3 12 1 3 9 20 ]
+// lower_bound(4) = 3, search(5) = Yes, search(8) = No
+// table                    length   sorted q/s    eytzinger    sorted lb eytzinger lb
+// input_64.txt                 64     30204180     40046454     31461381     41155651
+// input_1024.txt             1024     21177467     27789357     22265764     27976723
+// input_4096.txt             4096     17929180     24671864     16796842     27089259
+// input_65536.txt           65536     14720170     17385560     12812136     16633953
+// synthetic 256KiB          65536     10710537     15846354     10841401     16379748
+// synthetic 1024KiB        262144      9407957     12052404      9336545     10683647
+// synthetic 4096KiB       1048576      5609532      9925460      6190072      7453342
+// synthetic 16384KiB      4194304      4300539      6657036      4312036      5418292
+// synthetic 65536KiB     16777216      3222117      4698321      3043121      3353533
+// synthetic 262144KiB    67108864      1869023      3332034      1994471      3054442
+// synthetic 1048576KiB  268435456      1295214      2585396      1332830      2247181
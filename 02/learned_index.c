@@ -0,0 +1,371 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_QUERIES 1000000
+#define SYNTHETIC_LENGTH 10000000
+#define NUM_RECORDS 1000000
+
+// 昇順の表の key と位置の関係 (累積分布) がなめらかであれば、
+// key から位置をほぼ直線で予測できます。この「学習済みインデックス」は
+// 表を折れ線 (区分線形関数) で近似し、どの key についても予測した位置と
+// 実際の位置の差が epsilon 以下になるように線分を区切ります。
+// 探索は 1. x を含む線分を探す 2. 位置を予測する 3. 予測位置の前後
+// epsilon 以内だけを二分探索する、の 3 段階です。
+//
+// 表は binary_search.c の int の配列でも、06/binary_search.c の
+// record の配列でも使えるように、先頭アドレスと要素の間隔 (stride) で
+// 受け取ります。
+
+typedef struct {
+    const char* base;
+    size_t stride;
+    int length;
+} key_array;
+
+static inline int key_at(const key_array* a, int i) {
+    return *(const int*)(a->base + (size_t)i * a->stride);
+}
+
+typedef struct {
+    int key;           // 線分が受け持つ最小の key
+    int position;      // key の位置
+    double slope;      // key が 1 増えたときに位置がいくつ進むか
+} segment;
+
+typedef struct {
+    key_array keys;
+    int epsilon;
+    int num_segments;
+    segment* segments;
+    // 線分を探すための、segments[i].key だけを並べた配列です。
+    int* first_keys;
+} learned_index;
+
+// shrinking cone と呼ばれる方法で線分を作ります。
+// 線分の始点 (k0, p0) を固定すると、各点 (k, p) について
+// |p0 + slope * (k - k0) - p| <= epsilon を満たす傾きの範囲が決まります。
+// 点を追加するたびにその範囲の共通部分を取り、空になったらそこで線分を
+// 区切って新しい線分を始めます。
+// 同じ key が続く場合は、最後の位置だけを点として使います
+// (探索は「x 以下となる最後の位置」を求めるため)。
+void build(learned_index* index, key_array keys, int epsilon) {
+    index->keys = keys;
+    index->epsilon = epsilon;
+    index->num_segments = 0;
+    int capacity = 16;
+    index->segments = (segment*)malloc(capacity * sizeof(segment));
+
+    int i = 0;
+    while (i < keys.length) {
+        // 始点は同じ key の最後の位置にします。
+        while (i + 1 < keys.length && key_at(&keys, i + 1) == key_at(&keys, i)) {
+            i++;
+        }
+        int k0 = key_at(&keys, i);
+        int p0 = i;
+        double low = 0;
+        double high = 1e300;
+        i++;
+        while (i < keys.length) {
+            while (i + 1 < keys.length && key_at(&keys, i + 1) == key_at(&keys, i)) {
+                i++;
+            }
+            double dx = (double)key_at(&keys, i) - k0;
+            double new_low = (i - epsilon - p0) / dx;
+            double new_high = (i + epsilon - p0) / dx;
+            if (new_low > high || new_high < low) {
+                break;
+            }
+            low = new_low > low ? new_low : low;
+            high = new_high < high ? new_high : high;
+            i++;
+        }
+
+        if (index->num_segments == capacity) {
+            capacity *= 2;
+            index->segments = (segment*)realloc(index->segments, capacity * sizeof(segment));
+        }
+        segment* s = &index->segments[index->num_segments++];
+        s->key = k0;
+        s->position = p0;
+        s->slope = high == 1e300 ? 0 : (low + high) / 2;
+    }
+
+    index->first_keys = (int*)malloc(index->num_segments * sizeof(int));
+    for (int j = 0; j < index->num_segments; j++) {
+        index->first_keys[j] = index->segments[j].key;
+    }
+}
+
+void destroy(learned_index* index) {
+    free(index->segments);
+    free(index->first_keys);
+}
+
+size_t index_bytes(const learned_index* index) {
+    return index->num_segments * (sizeof(segment) + sizeof(int));
+}
+
+// keys[low, high) の中で x 以下となる最後の位置を返します。
+// 存在しない場合は low - 1 を返します。
+int bounded_search(const key_array* keys, int low, int high, int x) {
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (x < key_at(keys, middle)) {
+            high = middle;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return low - 1;
+}
+
+// x 以下となる最後の位置を返します。存在しない場合は -1 を返します。
+// binary_search.c の binary_search の high や、06/binary_search.c の search の
+// 戻り値と同じ値です。
+int learned_search(const learned_index* index, int x) {
+    const key_array* keys = &index->keys;
+    if (keys->length == 0 || x < index->first_keys[0]) {
+        return -1;
+    }
+
+    // 1. x 以下となる最後の線分 (線分の数は表よりずっと少ない)
+    int s = bounded_search(&(key_array){(const char*)index->first_keys, sizeof(int), index->num_segments},
+                           0, index->num_segments, x);
+    const segment* seg = &index->segments[s];
+
+    // 2. 位置の予測
+    double predicted = seg->position + seg->slope * ((double)x - seg->key);
+    double clamped = predicted < 0 ? 0 : predicted > keys->length ? keys->length : predicted;
+    int low = (int)clamped - index->epsilon;
+    int high = (int)clamped + index->epsilon + 2;
+    low = low < 0 ? 0 : low > keys->length - 1 ? keys->length - 1 : low;
+    high = high > keys->length ? keys->length : high < low + 1 ? low + 1 : high;
+
+    // 表に無い x は線分の外挿になるため、予測が外れることがあります。
+    // その場合は外れた方向へ幅を倍々に広げて (galloping) 範囲を直します。
+    int step = index->epsilon + 1;
+    while (low > 0 && key_at(keys, low) > x) {
+        high = low;
+        low = low > step ? low - step : 0;
+        step *= 2;
+    }
+    while (high < keys->length && key_at(keys, high) <= x) {
+        low = high;
+        high = keys->length - high > step ? high + step : keys->length;
+        step *= 2;
+    }
+
+    // 3. 範囲内の二分探索
+    return bounded_search(keys, low, high, x);
+}
+
+// 比較用の二分探索です (binary_search.c の binary_search の high を返すものです)。
+int binary_search(const key_array* keys, int x) {
+    return bounded_search(keys, 0, keys->length, x);
+}
+
+// 比較用の補間探索です。
+// table[low] <= x < table[high] を保ちながら、二分探索のように真ん中ではなく
+// 値の比から x がありそうな位置を計算して調べます。
+int interpolation_search(const key_array* keys, int x) {
+    int n = keys->length;
+    if (n == 0 || x < key_at(keys, 0)) {
+        return -1;
+    }
+    if (x >= key_at(keys, n - 1)) {
+        return n - 1;
+    }
+    int low = 0;
+    int high = n - 1;
+    while (high - low > 1) {
+        int key_low = key_at(keys, low);
+        int key_high = key_at(keys, high);
+        int position = low + (int)(((int64_t)x - key_low) * (high - low) / ((int64_t)key_high - key_low));
+        if (position <= low) {
+            position = low + 1;
+        } else if (position >= high) {
+            position = high - 1;
+        }
+        if (key_at(keys, position) <= x) {
+            low = position;
+        } else {
+            high = position;
+        }
+    }
+    return low;
+}
+
+// 入力を作るために用意した本題とは関係ない関数です。
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+int compare_int(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+int* load(const char* path, int* length) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fscanf(fp, "%d", length) != 1) {
+        fclose(fp);
+        return NULL;
+    }
+    int* table = (int*)malloc(*length * sizeof(int));
+    for (int i = 0; i < *length; i++) {
+        if (fscanf(fp, "%d", &table[i]) != 1) {
+            free(table);
+            fclose(fp);
+            return NULL;
+        }
+    }
+    fclose(fp);
+    qsort(table, *length, sizeof(int), compare_int);
+    return table;
+}
+
+double seconds_since(long start_clock) {
+    return (double)(clock() - start_clock) / CLOCKS_PER_SEC;
+}
+
+void benchmark(const char* name, key_array keys, int* targets, int* expected) {
+    uint64_t state = 88172645463325252ULL;
+    int64_t min_key = key_at(&keys, 0);
+    int64_t range = (int64_t)key_at(&keys, keys.length - 1) - min_key + 2;
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        // 半分は表の中の key、残りは範囲内のランダムな値にします。
+        uint64_t r = xorshift64(&state);
+        targets[i] = (r & 1) ? key_at(&keys, (r >> 1) % keys.length) : (int)(min_key - 1 + (int64_t)((r >> 1) % range));
+    }
+
+    long start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        expected[i] = binary_search(&keys, targets[i]);
+    }
+    double binary = seconds_since(start_clock) * 1e9 / NUM_QUERIES;
+
+    int num_mismatches = 0;
+    start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        num_mismatches += interpolation_search(&keys, targets[i]) != expected[i];
+    }
+    double interpolation = seconds_since(start_clock) * 1e9 / NUM_QUERIES;
+    printf("%-22s %9d  binary %6.1lf ns  interpolation %6.1lf ns\n", name, keys.length, binary, interpolation);
+
+    int epsilons[] = {8, 32, 128};
+    for (int e = 0; e < 3; e++) {
+        learned_index index;
+        build(&index, keys, epsilons[e]);
+        start_clock = clock();
+        for (int i = 0; i < NUM_QUERIES; i++) {
+            num_mismatches += learned_search(&index, targets[i]) != expected[i];
+        }
+        double learned = seconds_since(start_clock) * 1e9 / NUM_QUERIES;
+        printf("    epsilon %4d: %7d segments, %9zu bytes (%5.2lf bytes/key), learned %6.1lf ns\n",
+               epsilons[e], index.num_segments, index_bytes(&index),
+               (double)index_bytes(&index) / keys.length, learned);
+        destroy(&index);
+    }
+    assert(num_mismatches == 0);
+}
+
+// 06/binary_search.c の record です。
+typedef struct {
+    int key;
+    char value[32];
+} record;
+
+int main(int argc, char** argv) {
+    int* targets = (int*)malloc(NUM_QUERIES * sizeof(int));
+    int* expected = (int*)malloc(NUM_QUERIES * sizeof(int));
+
+    // 引数で渡された input_*.txt
+    for (int i = 1; i < argc; i++) {
+        int length;
+        int* table = load(argv[i], &length);
+        if (table == NULL) {
+            printf("%s: failed to load\n", argv[i]);
+            continue;
+        }
+        benchmark(argv[i], (key_array){(const char*)table, sizeof(int), length}, targets, expected);
+        free(table);
+    }
+
+    // 合成した表: 一様乱数を並べたもの (なめらか) と、その 2 乗 (偏りがある)
+    int* table = (int*)malloc(SYNTHETIC_LENGTH * sizeof(int));
+    uint64_t state = 2463534242ULL;
+    for (int i = 0; i < SYNTHETIC_LENGTH; i++) {
+        table[i] = (int)(xorshift64(&state) % 2000000000);
+    }
+    qsort(table, SYNTHETIC_LENGTH, sizeof(int), compare_int);
+    benchmark("uniform", (key_array){(const char*)table, sizeof(int), SYNTHETIC_LENGTH}, targets, expected);
+
+    for (int i = 0; i < SYNTHETIC_LENGTH; i++) {
+        double u = (double)(xorshift64(&state) % 1000000) / 1000000;
+        table[i] = (int)(u * u * u * 2000000000);
+    }
+    qsort(table, SYNTHETIC_LENGTH, sizeof(int), compare_int);
+    benchmark("cubic (skewed)", (key_array){(const char*)table, sizeof(int), SYNTHETIC_LENGTH}, targets, expected);
+    free(table);
+
+    // record の表
+    record* records = (record*)malloc(NUM_RECORDS * sizeof(record));
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        records[i].key = i * 7 + (int)(xorshift64(&state) % 7);
+        strcpy(records[i].value, "AAA");
+    }
+    benchmark("records (06)", (key_array){(const char*)records, sizeof(record), NUM_RECORDS}, targets, expected);
+    free(records);
+
+    free(targets);
+    free(expected);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// $ ./a.out input_64.txt input_1024.txt input_4096.txt input_65536.txt
+// input_64.txt                  64  binary   55.1 ns  interpolation   17.3 ns
+//     epsilon    8:       1 segments,        20 bytes ( 0.31 bytes/key), learned   33.4 ns
+//     epsilon   32:       1 segments,        20 bytes ( 0.31 bytes/key), learned   58.2 ns
+//     epsilon  128:       1 segments,        20 bytes ( 0.31 bytes/key), learned   60.7 ns
+// input_1024.txt              1024  binary   92.1 ns  interpolation   17.4 ns
+//     epsilon    8:       1 segments,        20 bytes ( 0.02 bytes/key), learned   24.1 ns
+//     epsilon   32:       1 segments,        20 bytes ( 0.02 bytes/key), learned   33.6 ns
+//     epsilon  128:       1 segments,        20 bytes ( 0.02 bytes/key), learned   53.1 ns
+// input_4096.txt              4096  binary  110.6 ns  interpolation   18.3 ns
+//     epsilon    8:       1 segments,        20 bytes ( 0.00 bytes/key), learned   24.3 ns
+//     epsilon   32:       1 segments,        20 bytes ( 0.00 bytes/key), learned   31.1 ns
+//     epsilon  128:       1 segments,        20 bytes ( 0.00 bytes/key), learned   38.3 ns
+// input_65536.txt            65536  binary  160.3 ns  interpolation   19.0 ns
+//     epsilon    8:       1 segments,        20 bytes ( 0.00 bytes/key), learned   24.6 ns
+//     epsilon   32:       1 segments,        20 bytes ( 0.00 bytes/key), learned   31.0 ns
+//     epsilon  128:       1 segments,        20 bytes ( 0.00 bytes/key), learned   35.9 ns
+// uniform                 10000000  binary  420.1 ns  interpolation  336.7 ns
+//     epsilon    8:   51952 segments,   1039040 bytes ( 0.10 bytes/key), learned  293.9 ns
+//     epsilon   32:    3660 segments,     73200 bytes ( 0.01 bytes/key), learned  355.3 ns
+//     epsilon  128:     241 segments,      4820 bytes ( 0.00 bytes/key), learned  391.0 ns
+// cubic (skewed)          10000000  binary  436.1 ns  interpolation 8616.9 ns
+//     epsilon    8:   39814 segments,    796280 bytes ( 0.08 bytes/key), learned  272.6 ns
+//     epsilon   32:    3449 segments,     68980 bytes ( 0.01 bytes/key), learned  249.6 ns
+//     epsilon  128:     343 segments,      6860 bytes ( 0.00 bytes/key), learned  257.6 ns
+// records (06)             1000000  binary  369.2 ns  interpolation   44.2 ns
+//     epsilon    8:       1 segments,        20 bytes ( 0.00 bytes/key), learned   53.2 ns
+//     epsilon   32:       1 segments,        20 bytes ( 0.00 bytes/key), learned   55.4 ns
+//     epsilon  128:       1 segments,        20 bytes ( 0.00 bytes/key), learned   74.7 ns
@@ -0,0 +1,323 @@
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86_SIMD 1
+#else
+#define HAS_X86_SIMD 0
+#endif
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_QUERIES 1000000
+#define MAX_WINDOW 1024
+#define MAX_CROSSOVER 16384
+
+// linear_search.c の linear_search をそのまま持ってきたものです。
+bool linear_search(int* table, int length, int x) {
+    for (int i = 0; i < length; i++) {
+        if (x == table[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// binary_search.c の binary_search をそのまま持ってきたものです。
+bool binary_search(int* table, int length, int x) {
+    int low = 0;
+    int high = length - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (x < table[middle]) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return (high > -1) && (x == table[high]);
+}
+
+#if HAS_X86_SIMD
+// SSE4.1 版です。1 命令で 4 個、1 回のループで 16 個のキーを比較します。
+// 16 個分の比較結果をまとめて OR してから 1 回だけ判定するので、
+// 分岐の回数は 1/16 になります。見つかった時点でループを抜けます。
+__attribute__((target("sse4.1"))) bool linear_search_sse4(int* table, int length, int x) {
+    __m128i key = _mm_set1_epi32(x);
+    int i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m128i a = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(table + i)), key);
+        __m128i b = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(table + i + 4)), key);
+        __m128i c = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(table + i + 8)), key);
+        __m128i d = _mm_cmpeq_epi32(_mm_loadu_si128((const __m128i*)(table + i + 12)), key);
+        __m128i any = _mm_or_si128(_mm_or_si128(a, b), _mm_or_si128(c, d));
+        if (!_mm_testz_si128(any, any)) {
+            return true;
+        }
+    }
+    for (; i < length; i++) {
+        if (x == table[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// AVX2 版です。1 命令で 8 個、1 回のループで 16 個のキーを比較します。
+__attribute__((target("avx2"))) bool linear_search_avx2(int* table, int length, int x) {
+    __m256i key = _mm256_set1_epi32(x);
+    int i = 0;
+    for (; i + 16 <= length; i += 16) {
+        __m256i a = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(table + i)), key);
+        __m256i b = _mm256_cmpeq_epi32(_mm256_loadu_si256((const __m256i*)(table + i + 8)), key);
+        __m256i any = _mm256_or_si256(a, b);
+        if (!_mm256_testz_si256(any, any)) {
+            return true;
+        }
+    }
+    for (; i < length; i++) {
+        if (x == table[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif
+
+// 実行時に CPUID で CPU が対応している命令を調べて、使う関数を選びます。
+// 選ばれた関数は linear_search_simd から呼び出せます。
+bool (*linear_search_simd)(int* table, int length, int x) = linear_search;
+const char* linear_search_simd_name = "scalar";
+
+void init_linear_search_simd() {
+#if HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        linear_search_simd = linear_search_avx2;
+        linear_search_simd_name = "avx2";
+        return;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        linear_search_simd = linear_search_sse4;
+        linear_search_simd_name = "sse4.1";
+        return;
+    }
+#endif
+    linear_search_simd = linear_search;
+    linear_search_simd_name = "scalar";
+}
+
+// 昇順の表に対して、候補が window 個以下になるまでは二分探索で絞り込み、
+// 残りを SIMD の線形探索で調べます。
+// 二分探索の最後の数段は分岐予測が外れやすく、また同じキャッシュライン
+// の中を行き来するだけなので、まとめて比較した方が速くなります。
+bool hybrid_search(int* table, int length, int x, int window) {
+    int low = 0;
+    int high = length;
+    // x が表に含まれるならば、[low, high) に含まれます。
+    while (high - low > window) {
+        int middle = (low + high) / 2;
+        if (table[middle] <= x) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return linear_search_simd(table + low, high - low, x);
+}
+
+// 計測結果です。クエリプランナーはこれらを見て探索方法を選びます。
+// linear_binary_crossover: これ以上の要素数では二分探索の方が速い
+// hybrid_window: hybrid_search の window として最も速かった値
+int linear_binary_crossover = 0;
+int hybrid_window = 16;
+
+// 二分探索は昇順の表にしか使えないため、sorted も受け取ります。
+typedef enum {
+    LINEAR,
+    HYBRID,
+} search_method;
+
+search_method choose_method(int length, bool sorted) {
+    if (!sorted || length < linear_binary_crossover) {
+        return LINEAR;
+    }
+    return HYBRID;
+}
+
+// 入力を作るために用意した本題とは関係ない関数です。
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+int* load(const char* path, int* length) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fscanf(fp, "%d", length) != 1) {
+        fclose(fp);
+        return NULL;
+    }
+    int* table = (int*)malloc(*length * sizeof(int));
+    for (int i = 0; i < *length; i++) {
+        if (fscanf(fp, "%d", &table[i]) != 1) {
+            free(table);
+            fclose(fp);
+            return NULL;
+        }
+    }
+    fclose(fp);
+    return table;
+}
+
+// 表の値 (0, 2, 4, ...) の範囲から、半分程度が見つかるように target を作ります。
+void make_targets(int* targets, int max_value) {
+    uint64_t state = 88172645463325252ULL;
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        targets[i] = (int)(xorshift64(&state) % ((uint64_t)max_value + 1));
+    }
+}
+
+// 1 クエリあたりの時間 (ns) を返します。
+double time_search(bool (*search)(int*, int, int), int* table, int length, int* targets, int num_queries) {
+    volatile int found = 0;
+    long start_clock = clock();
+    for (int i = 0; i < num_queries; i++) {
+        found += search(table, length, targets[i]);
+    }
+    return (double)(clock() - start_clock) / CLOCKS_PER_SEC * 1e9 / num_queries;
+}
+
+double time_hybrid(int* table, int length, int* targets, int window) {
+    volatile int found = 0;
+    long start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        found += hybrid_search(table, length, targets[i], window);
+    }
+    return (double)(clock() - start_clock) / CLOCKS_PER_SEC * 1e9 / NUM_QUERIES;
+}
+
+int main(int argc, char** argv) {
+    init_linear_search_simd();
+    printf("selected kernel: %s\n", linear_search_simd_name);
+
+    int* targets = (int*)malloc(NUM_QUERIES * sizeof(int));
+
+    // 1. 引数で渡された input_*.txt に対する線形探索
+    printf("\n%-16s %8s %12s %12s\n", "table", "length", "scalar ns", "simd ns");
+    for (int i = 1; i < argc; i++) {
+        int length;
+        int* table = load(argv[i], &length);
+        if (table == NULL) {
+            printf("%s: failed to load\n", argv[i]);
+            continue;
+        }
+        int num_queries = NUM_QUERIES / length * 16 + 1;
+        if (num_queries > NUM_QUERIES) {
+            num_queries = NUM_QUERIES;
+        }
+        make_targets(targets, length * 2);
+        double scalar = time_search(linear_search, table, length, targets, num_queries);
+        double simd = time_search(linear_search_simd, table, length, targets, num_queries);
+        printf("%-16s %8d %12.1lf %12.1lf\n", argv[i], length, scalar, simd);
+        free(table);
+    }
+
+    // 2. 線形探索と二分探索の損益分岐点
+    int* table = (int*)malloc(MAX_WINDOW * 64 * sizeof(int));
+    for (int i = 0; i < MAX_WINDOW * 64; i++) {
+        table[i] = i * 2;
+    }
+    printf("\n%8s %12s %12s %12s\n", "length", "scalar ns", "simd ns", "binary ns");
+    for (int length = 4; length <= MAX_CROSSOVER; length *= 2) {
+        make_targets(targets, length * 2);
+        double scalar = time_search(linear_search, table, length, targets, NUM_QUERIES);
+        double simd = time_search(linear_search_simd, table, length, targets, NUM_QUERIES);
+        double binary = time_search(binary_search, table, length, targets, NUM_QUERIES);
+        printf("%8d %12.1lf %12.1lf %12.1lf\n", length, scalar, simd, binary);
+        if (linear_binary_crossover == 0 && binary < simd) {
+            linear_binary_crossover = length;
+        }
+    }
+    if (linear_binary_crossover == 0) {
+        linear_binary_crossover = MAX_CROSSOVER * 2;
+    }
+    printf("linear_binary_crossover = %d\n", linear_binary_crossover);
+
+    // 3. hybrid_search の window の調整
+    int length = MAX_WINDOW * 64;
+    make_targets(targets, length * 2);
+    printf("\n%8s %12s (length %d, binary_search %.1lf ns)\n", "window", "hybrid ns", length,
+           time_search(binary_search, table, length, targets, NUM_QUERIES));
+    double best = 1e30;
+    for (int window = 4; window <= MAX_WINDOW; window *= 2) {
+        double t = time_hybrid(table, length, targets, window);
+        printf("%8d %12.1lf\n", window, t);
+        if (t < best) {
+            best = t;
+            hybrid_window = window;
+        }
+    }
+    printf("hybrid_window = %d\n", hybrid_window);
+
+    const char* names[] = {"linear", "hybrid"};
+    printf("\nchoose_method(10, sorted)       = %s\n", names[choose_method(10, true)]);
+    printf("choose_method(65536, sorted)    = %s\n", names[choose_method(65536, true)]);
+    printf("choose_method(65536, unsorted)  = %s\n", names[choose_method(65536, false)]);
+
+    free(table);
+    free(targets);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// $ ./a.out input_64.txt input_1024.txt input_4096.txt input_65536.txt
+// selected kernel: avx2
+//
+// table              length    scalar ns      simd ns
+// input_64.txt           64         39.6         15.4
+// input_1024.txt       1024        499.1         76.8
+// input_4096.txt       4096       1950.6        270.9
+// input_65536.txt     65536      31888.0       4614.1
+//
+//   length    scalar ns      simd ns    binary ns
+//        4          9.8         12.7         13.6
+//        8         11.4         14.2         20.8
+//       16         15.8         13.1         29.6
+//       32         22.7         14.7         40.0
+//       64         37.9         16.3         48.7
+//      128         74.0         19.9         55.4
+//      256        136.1         28.0         60.9
+//      512        244.1         42.7         68.6
+//     1024        469.2         64.8         70.3
+//     2048        602.4         91.2         70.1
+//     4096       1157.3        257.0         86.6
+//     8192       2921.7        495.2         96.1
+//    16384       5472.6        932.7         90.6
+// linear_binary_crossover = 2048
+//
+//   window    hybrid ns (length 65536, binary_search 119.6 ns)
+//        4         72.0
+//        8         77.3
+//       16         63.4
+//       32         60.2
+//       64         58.4
+//      128         59.7
+//      256         73.3
+//      512         80.4
+//     1024        100.1
+// hybrid_window = 64
+//
+// choose_method(10, sorted)       = linear
+// choose_method(65536, sorted)    = hybrid
+// choose_method(65536, unsorted)  = linear
@@ -0,0 +1,393 @@
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86_SIMD 1
+#else
+#define HAS_X86_SIMD 0
+#endif
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_QUERIES 1000000
+// 合成した表の最大要素数です。LLC を超える大きさまで計測します。
+#define MAX_SYNTHETIC_LENGTH (1 << 26)
+// まとめて探索するクエリの数です。
+#define GROUP 16
+
+// 1 つのノードに入れるキーの数です。16 個の int でちょうど 64 byte
+// (キャッシュライン 1 本) になります。
+#define B 16
+
+// binary_search.c の binary_search をそのまま持ってきたものです。
+bool binary_search(int* table, int length, int x) {
+    int low = 0;
+    int high = length - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (x < table[middle]) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return (high > -1) && (x == table[high]);
+}
+
+// 静的な B 木 (S-tree) です。
+// 昇順の表を、1 ノードに B 個のキーと B + 1 個の子を持つ B 木に並べ直します。
+// 木は変更しないので子へのポインタは持たず、eytzinger.c と同じように
+// ノード k の i 番目の子を k * (B + 1) + i + 1 番目のノードとして計算します。
+// 二分探索では 1 回の比較ごとに別のキャッシュラインを読むことがありますが、
+// S-tree では 1 本のキャッシュラインで B 個のキーを比較できるので、
+// キャッシュミスはおよそ log_17(n) 回で済みます。
+// 最後のノードの空いている場所には INT_MAX を入れておきます。
+// rank[k * B + i] は nodes[k][i] が元の昇順の表で何番目だったかを表します。
+typedef struct {
+    int length;
+    int num_nodes;
+    int (*nodes)[B];
+    int* rank;
+} s_tree;
+
+static inline int child(int k, int i) {
+    return k * (B + 1) + i + 1;
+}
+
+// 木の中間順 (in-order) に昇順の表の要素を順番に置いていきます。
+int build_recursive(s_tree* t, const int* sorted, int i, int k) {
+    if (k < t->num_nodes) {
+        for (int j = 0; j < B; j++) {
+            i = build_recursive(t, sorted, i, child(k, j));
+            t->nodes[k][j] = i < t->length ? sorted[i] : INT_MAX;
+            t->rank[k * B + j] = i < t->length ? i : t->length;
+            i++;
+        }
+        i = build_recursive(t, sorted, i, child(k, B));
+    }
+    return i;
+}
+
+void build(s_tree* t, const int* sorted, int length) {
+    t->length = length;
+    t->num_nodes = (length + B - 1) / B;
+    t->nodes = (int(*)[B])aligned_alloc(64, (size_t)t->num_nodes * sizeof(t->nodes[0]));
+    t->rank = (int*)malloc((size_t)t->num_nodes * B * sizeof(int));
+    build_recursive(t, sorted, 0, 0);
+}
+
+void destroy(s_tree* t) {
+    free(t->nodes);
+    free(t->rank);
+}
+
+// ノードの中で x より小さいキーの数を返します。
+// ノードの中も昇順に並んでいるので、これが x 以上となる最初のキーの位置です。
+int rank_in_node_scalar(const int* node, int x) {
+    int count = 0;
+    for (int i = 0; i < B; i++) {
+        count += node[i] < x;
+    }
+    return count;
+}
+
+#if HAS_X86_SIMD
+// AVX2 版です。8 個ずつ 2 回比較して、結果のビットを数えます。
+// 分岐は無く、ノード 1 つを数命令で調べられます。
+__attribute__((target("avx2,popcnt"))) int rank_in_node_avx2(const int* node, int x) {
+    __m256i key = _mm256_set1_epi32(x);
+    __m256i a = _mm256_cmpgt_epi32(key, _mm256_load_si256((const __m256i*)node));
+    __m256i b = _mm256_cmpgt_epi32(key, _mm256_load_si256((const __m256i*)(node + 8)));
+    unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(a)) |
+                    (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(b)) << 8;
+    return __builtin_popcount(mask);
+}
+
+// SSE2 版です。4 個ずつ 4 回比較します。
+int rank_in_node_sse2(const int* node, int x) {
+    __m128i key = _mm_set1_epi32(x);
+    unsigned mask = 0;
+    for (int i = 0; i < B; i += 4) {
+        __m128i c = _mm_cmpgt_epi32(key, _mm_load_si128((const __m128i*)(node + i)));
+        mask |= (unsigned)_mm_movemask_ps(_mm_castsi128_ps(c)) << i;
+    }
+    return __builtin_popcount(mask);
+}
+#endif
+
+// 実行時に CPU が対応している命令を調べて、使う関数を選びます。
+int (*rank_in_node)(const int* node, int x) = rank_in_node_scalar;
+const char* rank_in_node_name = "scalar";
+
+void init_rank_in_node() {
+#if HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt")) {
+        rank_in_node = rank_in_node_avx2;
+        rank_in_node_name = "avx2";
+        return;
+    }
+    rank_in_node = rank_in_node_sse2;
+    rank_in_node_name = "sse2";
+#else
+    rank_in_node = rank_in_node_scalar;
+    rank_in_node_name = "scalar";
+#endif
+}
+
+// x 以上となる最初の要素の、元の昇順の表での位置を返します。
+// 該当する要素が無い場合は length を返します。
+// 木を下りながら各ノードで x 以上となる最初のキーを候補として覚えます。
+// 深いノードの候補ほど x に近いので、最後に覚えた候補が答えです。
+int s_tree_lower_bound(const s_tree* t, int x) {
+    int result = t->length;
+    int k = 0;
+    while (k < t->num_nodes) {
+        int i = rank_in_node(t->nodes[k], x);
+        if (i < B) {
+            result = t->rank[k * B + i];
+        }
+        k = child(k, i);
+    }
+    return result;
+}
+
+// binary_search と同じく、x が表に含まれるかどうかを返します。
+bool s_tree_search(const s_tree* t, const int* sorted, int x) {
+    int i = s_tree_lower_bound(t, x);
+    return i < t->length && sorted[i] == x;
+}
+
+// GROUP 個のクエリを 1 段ずつ同時に進めます。
+// 1 つのクエリの次のノードを読んでいる間に他のクエリのノードを
+// 読み込めるように、次に読むノードを先読みしておきます。
+void s_tree_lower_bound_batch(const s_tree* t, const int* targets, int* results, int count) {
+    for (int start = 0; start < count; start += GROUP) {
+        int n = count - start < GROUP ? count - start : GROUP;
+        int k[GROUP];
+        for (int j = 0; j < n; j++) {
+            k[j] = 0;
+            results[start + j] = t->length;
+        }
+        // 葉の深さはすべてのクエリで高々 1 段しか違わないので、
+        // すべてのクエリが木の外に出るまで続けます。
+        bool active = true;
+        while (active) {
+            active = false;
+            for (int j = 0; j < n; j++) {
+                if (k[j] < t->num_nodes) {
+                    int i = rank_in_node(t->nodes[k[j]], targets[start + j]);
+                    if (i < B) {
+                        results[start + j] = t->rank[k[j] * B + i];
+                    }
+                    k[j] = child(k[j], i);
+                    if (k[j] < t->num_nodes) {
+                        __builtin_prefetch(t->nodes[k[j]]);
+                        active = true;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// 比較用の、昇順の表に対する lower bound です。
+int lower_bound(const int* table, int length, int x) {
+    int low = 0;
+    int high = length;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (table[middle] < x) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// 入力を作るために用意した本題とは関係ない関数です。
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+int compare_int(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// input_*.txt を読み込みます。二分探索のために読み込んだ後で並べ替えます。
+int* load(const char* path, int* length) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fscanf(fp, "%d", length) != 1) {
+        fclose(fp);
+        return NULL;
+    }
+    int* table = (int*)malloc(*length * sizeof(int));
+    for (int i = 0; i < *length; i++) {
+        if (fscanf(fp, "%d", &table[i]) != 1) {
+            free(table);
+            fclose(fp);
+            return NULL;
+        }
+    }
+    fclose(fp);
+    qsort(table, *length, sizeof(int), compare_int);
+    return table;
+}
+
+double seconds_since(long start_clock) {
+    return (double)(clock() - start_clock) / CLOCKS_PER_SEC;
+}
+
+void benchmark(const char* name, int* table, int length, int* targets, bool* found, int* ranks, int* results) {
+    s_tree t;
+    build(&t, table, length);
+
+    // 半分程度が見つかるように、表の最大値の 2 倍までの範囲から選びます。
+    uint64_t state = 88172645463325252ULL;
+    uint64_t range = (uint64_t)table[length - 1] * 2 + 2;
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        targets[i] = (int)(xorshift64(&state) % range);
+    }
+
+    long start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        found[i] = binary_search(table, length, targets[i]);
+    }
+    double sorted_search = seconds_since(start_clock);
+
+    start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        ranks[i] = lower_bound(table, length, targets[i]);
+    }
+    double sorted_lower_bound = seconds_since(start_clock);
+
+    int num_mismatches = 0;
+    start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        num_mismatches += s_tree_search(&t, table, targets[i]) != found[i];
+    }
+    double s_tree_time = seconds_since(start_clock);
+
+    start_clock = clock();
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        num_mismatches += s_tree_lower_bound(&t, targets[i]) != ranks[i];
+    }
+    double s_tree_lower_bound_time = seconds_since(start_clock);
+
+    start_clock = clock();
+    s_tree_lower_bound_batch(&t, targets, results, NUM_QUERIES);
+    double s_tree_batch_time = seconds_since(start_clock);
+    for (int i = 0; i < NUM_QUERIES; i++) {
+        num_mismatches += results[i] != ranks[i];
+    }
+    assert(num_mismatches == 0);
+
+    printf("%-20s %10d %12.0lf %12.0lf %12.0lf %12.0lf %12.0lf\n", name, length,
+           NUM_QUERIES / sorted_search, NUM_QUERIES / s_tree_time,
+           NUM_QUERIES / sorted_lower_bound, NUM_QUERIES / s_tree_lower_bound_time,
+           NUM_QUERIES / s_tree_batch_time);
+    destroy(&t);
+}
+
+int main(int argc, char** argv) {
+    init_rank_in_node();
+    printf("selected kernel: %s\n", rank_in_node_name);
+
+    int* targets = (int*)malloc(NUM_QUERIES * sizeof(int));
+    bool* found = (bool*)malloc(NUM_QUERIES * sizeof(bool));
+    int* ranks = (int*)malloc(NUM_QUERIES * sizeof(int));
+    int* results = (int*)malloc(NUM_QUERIES * sizeof(int));
+
+    // 小さな例で並び方を確認します。
+    int example[40];
+    for (int i = 0; i < 40; i++) {
+        example[i] = i * 2;
+    }
+    s_tree t;
+    build(&t, example, 40);
+    for (int k = 0; k < t.num_nodes; k++) {
+        printf("NODE %d: [ ", k);
+        for (int i = 0; i < B; i++) {
+            if (t.nodes[k][i] == INT_MAX) {
+                printf("- ");
+            } else {
+                printf("%d ", t.nodes[k][i]);
+            }
+        }
+        printf("]\n");
+    }
+    printf("lower_bound(33) = %d, search(34) = %s, search(35) = %s\n",
+           s_tree_lower_bound(&t, 33), s_tree_search(&t, example, 34) ? "Yes" : "No",
+           s_tree_search(&t, example, 35) ? "Yes" : "No");
+    destroy(&t);
+
+    printf("%-20s %10s %12s %12s %12s %12s %12s\n", "table", "length", "sorted q/s", "s-tree",
+           "sorted lb", "s-tree lb", "s-tree batch");
+
+    // 引数で渡された input_*.txt
+    for (int i = 1; i < argc; i++) {
+        int length;
+        int* table = load(argv[i], &length);
+        if (table == NULL) {
+            printf("%s: failed to load\n", argv[i]);
+            continue;
+        }
+        benchmark(argv[i], table, length, targets, found, ranks, results);
+        free(table);
+    }
+
+    // 合成した表 (0, 2, 4, ...)
+    for (long long size = 1 << 16; size <= MAX_SYNTHETIC_LENGTH; size <<= 2) {
+        int length = (int)size;
+        int* table = (int*)malloc((size_t)length * sizeof(int));
+        for (int i = 0; i < length; i++) {
+            table[i] = i * 2;
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "synthetic %dKiB", (int)((size_t)length * sizeof(int) >> 10));
+        benchmark(name, table, length, targets, found, ranks, results);
+        free(table);
+    }
+
+    free(targets);
+    free(found);
+    free(ranks);
+    free(results);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// $ ./a.out input_64.txt input_1024.txt input_4096.txt input_65536.txt
+// selected kernel: avx2
+// NODE 0: [ 32 66 68 70 72 74 76 78 - - - - - - - - ]
+// NODE 1: [ 0 2 4 6 8 10 12 14 16 18 20 22 24 26 28 30 ]
+// NODE 2: [ 34 36 38 40 42 44 46 48 50 52 54 56 58 60 62 64 ]
+// lower_bound(33) = 17, search(34) = Yes, search(35) = No
+// table                    length   sorted q/s       s-tree    sorted lb    s-tree lb s-tree batch
+// input_64.txt                 64     33316675     59438897     35701535     64008193     41911148
+// input_1024.txt             1024     21391747     49588416     23313827     44128679     26100801
+// input_4096.txt             4096     17252088     53507411     18526066     53333333     30022817
+// input_65536.txt           65536     13703699     24659696     13353631     36652861     18979654
+// synthetic 256KiB          65536     11726491     36737693     13070870     43729229     22698899
+// synthetic 1024KiB        262144     10329085     18432500     10684902     27736174     17771459
+// synthetic 4096KiB       1048576      6140545      4549860      6052060      7705526     14272054
+// synthetic 16384KiB      4194304      4156535      3309089      4208666      5637455      8769776
+// synthetic 65536KiB     16777216      2544005      2737993      2615665      4500956      8942064
+// synthetic 262144KiB    67108864      1655550      2148994      1753838      3115837      7946851
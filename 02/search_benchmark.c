@@ -0,0 +1,339 @@
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAS_RDTSC 1
+#else
+#define HAS_RDTSC 0
+#endif
+
+// binary_search.c と linear_search.c の計測は clock() で 1 回の呼び出しを
+// 挟んでいるだけなので、時計の分解能 (1 us) より短い時間は測れません。
+// このプログラムは表ごとに大量のクエリ (見つかるもの・見つからないもの半々)
+// を実行し、1 クエリごとのレイテンシの平均・中央値・p99・p99.9 と
+// 1 秒あたりのクエリ数を CSV または JSON で出力します。
+// 引数で渡した表の後に、合成した表 (0, 2, 4, ...) も計測します。
+//
+// 使い方:
+//   ./a.out input_64.txt input_1024.txt input_4096.txt input_65536.txt
+//   ./a.out -j -n 10000000 input_*.txt   # JSON で出力、クエリ数を指定
+
+#define DEFAULT_NUM_QUERIES 1000000
+// 線形探索は 1 クエリで表全体を読むことがあるため、
+// 表の長さ * クエリ数がこの値を超えないようにクエリ数を減らします。
+#define LINEAR_BUDGET (1LL << 30)
+// 見つからない値を表の最小値から最大値までの範囲で選ぶときに、選び直す回数の上限です。
+#define MISS_ATTEMPTS 16
+// 合成した表 (0, 2, 4, ...) の長さです。
+#define SYNTHETIC_LENGTH 65536
+
+// linear_search.c の linear_search をそのまま持ってきたものです。
+bool linear_search(int* table, int length, int x) {
+    for (int i = 0; i < length; i++) {
+        if (x == table[i]) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// binary_search.c の binary_search をそのまま持ってきたものです。
+bool binary_search(int* table, int length, int x) {
+    int low = 0;
+    int high = length - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (x < table[middle]) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return (high > -1) && (x == table[high]);
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 1 クエリの時間は数十 ns しかないため、clock_gettime の呼び出し自体の
+// 時間が無視できません。x86 ではより軽い rdtsc でサイクル数を読み、
+// 起動時に CLOCK_MONOTONIC と比べて ns に換算します。
+// lfence で前後の命令が rdtsc を追い越さないようにしています。
+double ns_per_tick = 1.0;
+uint64_t timer_overhead = 0;
+
+static inline uint64_t read_timer() {
+#if HAS_RDTSC
+    _mm_lfence();
+    uint64_t t = __rdtsc();
+    _mm_lfence();
+    return t;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+int compare_uint64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a;
+    uint64_t y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+void calibrate_timer() {
+#if HAS_RDTSC
+    double start = now();
+    uint64_t start_tick = read_timer();
+    while (now() - start < 0.1) {
+    }
+    ns_per_tick = (now() - start) * 1e9 / (read_timer() - start_tick);
+#endif
+    // 何もしない区間を測った値の中央値を、計測のたびに差し引きます。
+    uint64_t samples[1001];
+    for (int i = 0; i < 1001; i++) {
+        uint64_t t0 = read_timer();
+        uint64_t t1 = read_timer();
+        samples[i] = t1 - t0;
+    }
+    qsort(samples, 1001, sizeof(uint64_t), compare_uint64);
+    timer_overhead = samples[500];
+}
+
+// 入力を作るために用意した本題とは関係ない関数です。
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+int* load(const char* path, int* length) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return NULL;
+    }
+    if (fscanf(fp, "%d", length) != 1) {
+        fclose(fp);
+        return NULL;
+    }
+    int* table = (int*)malloc(*length * sizeof(int));
+    for (int i = 0; i < *length; i++) {
+        if (fscanf(fp, "%d", &table[i]) != 1) {
+            free(table);
+            fclose(fp);
+            return NULL;
+        }
+    }
+    fclose(fp);
+    return table;
+}
+
+int compare_int(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// 表に無い値を 1 つ選びます。table は昇順に並んでいる必要があります。
+// 表の最大値より大きい値ばかりにすると、binary_search は毎回同じ分岐をたどって
+// 分岐予測が当たり続けるため、見つからない場合のレイテンシが実際より小さく出ます。
+// そこで最小値から最大値までの一様乱数を選び、bsearch で表にあれば選び直します。
+// input_*.txt のように範囲の中の値がほとんどすべて表にある場合は、MISS_ATTEMPTS 回
+// 選び直しても見つからないので、最小値より小さい値か最大値より大きい値を半々で選びます。
+// int の範囲を越えないように、計算は int64_t で行います。
+int pick_miss(int* table, int length, uint64_t* state) {
+    int64_t low = table[0];
+    int64_t high = table[length - 1];
+    for (int attempt = 0; attempt < MISS_ATTEMPTS; attempt++) {
+        int x = (int)(low + (int64_t)(xorshift64(state) % (uint64_t)(high - low + 1)));
+        if (bsearch(&x, table, length, sizeof(int), compare_int) == NULL) {
+            return x;
+        }
+    }
+    uint64_t r = xorshift64(state);
+    int64_t offset = 1 + (int64_t)((r >> 1) % (uint64_t)length);
+    if (((r & 1) && low > INT_MIN) || high == INT_MAX) {
+        return (int)(low - offset > INT_MIN ? low - offset : INT_MIN);
+    }
+    return (int)(high + offset < INT_MAX ? high + offset : INT_MAX);
+}
+
+typedef struct {
+    const char* table;
+    int length;
+    const char* method;
+    int num_queries;
+    double hit_ratio;
+    double mean;
+    double p50;
+    double p99;
+    double p999;
+    double qps;
+} result;
+
+void measure(result* r, bool (*search)(int*, int, int), int* table, int length,
+             int* targets, int num_queries, uint64_t* samples) {
+    // スループットは 1 クエリごとの計測を挟まずに測ります。
+    int hits = 0;
+    double start = now();
+    for (int i = 0; i < num_queries; i++) {
+        hits += search(table, length, targets[i]);
+    }
+    r->qps = num_queries / (now() - start);
+    r->hit_ratio = (double)hits / num_queries;
+
+    // レイテンシは 1 クエリずつ計測します。
+    volatile int sink = 0;
+    for (int i = 0; i < num_queries; i++) {
+        uint64_t t0 = read_timer();
+        sink += search(table, length, targets[i]);
+        uint64_t t1 = read_timer();
+        uint64_t t = t1 - t0;
+        samples[i] = t > timer_overhead ? t - timer_overhead : 0;
+    }
+    qsort(samples, num_queries, sizeof(uint64_t), compare_uint64);
+
+    double sum = 0;
+    for (int i = 0; i < num_queries; i++) {
+        sum += samples[i];
+    }
+    r->num_queries = num_queries;
+    r->mean = sum / num_queries * ns_per_tick;
+    r->p50 = samples[(long long)num_queries * 500 / 1000] * ns_per_tick;
+    r->p99 = samples[(long long)num_queries * 990 / 1000] * ns_per_tick;
+    r->p999 = samples[(long long)num_queries * 999 / 1000] * ns_per_tick;
+}
+
+void print_result(const result* r, bool json, bool first) {
+    if (json) {
+        printf("%s  {\"table\": \"%s\", \"length\": %d, \"method\": \"%s\", \"queries\": %d, "
+               "\"hit_ratio\": %.3lf, \"mean_ns\": %.1lf, \"p50_ns\": %.1lf, \"p99_ns\": %.1lf, "
+               "\"p999_ns\": %.1lf, \"qps\": %.0lf}",
+               first ? "" : ",\n", r->table, r->length, r->method, r->num_queries,
+               r->hit_ratio, r->mean, r->p50, r->p99, r->p999, r->qps);
+    } else {
+        printf("%s,%d,%s,%d,%.3lf,%.1lf,%.1lf,%.1lf,%.1lf,%.0lf\n",
+               r->table, r->length, r->method, r->num_queries,
+               r->hit_ratio, r->mean, r->p50, r->p99, r->p999, r->qps);
+    }
+}
+
+// 1 つの表について、線形探索と二分探索を計測して結果を出力します。
+void benchmark(const char* name, int* table, int length, int* targets, int num_queries, uint64_t* samples,
+               bool json, bool first) {
+    // binary_search のために昇順に並べ替えておきます。
+    qsort(table, length, sizeof(int), compare_int);
+
+    // 半分は表の中からランダムに選んだ値 (見つかる)、残りの半分は表に無い値 (見つからない) にします。
+    uint64_t state = 88172645463325252ULL;
+    for (int q = 0; q < num_queries; q++) {
+        uint64_t r = xorshift64(&state);
+        if (r & 1) {
+            targets[q] = table[(r >> 1) % length];
+        } else {
+            targets[q] = pick_miss(table, length, &state);
+        }
+    }
+
+    result r;
+    r.table = name;
+    r.length = length;
+
+    r.method = "linear_search";
+    long long linear_queries = LINEAR_BUDGET / length;
+    measure(&r, linear_search, table, length, targets,
+            linear_queries < num_queries ? (int)linear_queries : num_queries, samples);
+    print_result(&r, json, first);
+
+    r.method = "binary_search";
+    measure(&r, binary_search, table, length, targets, num_queries, samples);
+    print_result(&r, json, false);
+}
+
+int main(int argc, char** argv) {
+    bool json = false;
+    int num_queries = DEFAULT_NUM_QUERIES;
+    int first_path = 1;
+    for (; first_path < argc && argv[first_path][0] == '-'; first_path++) {
+        if (strcmp(argv[first_path], "-j") == 0) {
+            json = true;
+        } else if (strcmp(argv[first_path], "-n") == 0 && first_path + 1 < argc) {
+            num_queries = atoi(argv[++first_path]);
+        }
+    }
+
+    calibrate_timer();
+
+    int* targets = (int*)malloc(num_queries * sizeof(int));
+    uint64_t* samples = (uint64_t*)malloc(num_queries * sizeof(uint64_t));
+
+    if (json) {
+        printf("[\n");
+    } else {
+        printf("table,length,method,queries,hit_ratio,mean_ns,p50_ns,p99_ns,p999_ns,qps\n");
+    }
+
+    bool first = true;
+    for (int i = first_path; i < argc; i++) {
+        int length;
+        int* table = load(argv[i], &length);
+        if (table == NULL) {
+            fprintf(stderr, "%s: failed to load\n", argv[i]);
+            continue;
+        }
+        benchmark(argv[i], table, length, targets, num_queries, samples, json, first);
+        first = false;
+        free(table);
+    }
+
+    // 合成した表 (0, 2, 4, ...) です。input_*.txt と違って範囲の中に表に無い値 (奇数) があるので、
+    // 見つからない値も表の全体に散らばります。
+    int* table = (int*)malloc(SYNTHETIC_LENGTH * sizeof(int));
+    if (table == NULL) {
+        fprintf(stderr, "synthetic: failed to allocate %d elements\n", SYNTHETIC_LENGTH);
+    } else {
+        for (int i = 0; i < SYNTHETIC_LENGTH; i++) {
+            table[i] = i * 2;
+        }
+        benchmark("synthetic", table, SYNTHETIC_LENGTH, targets, num_queries, samples, json, first);
+        free(table);
+    }
+
+    if (json) {
+        printf("\n]\n");
+    }
+
+    free(targets);
+    free(samples);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// input_*.txt は 1 から length までの値がほとんどすべて入っているので、見つからない値は
+// 表の両端の外側になります。synthetic では見つからない値が表の全体に散らばり、
+// binary_search の分岐が予測しにくくなるため、p50 が大きくなっています。
+// $ ./a.out input_64.txt input_1024.txt input_4096.txt input_65536.txt
+// table,length,method,queries,hit_ratio,mean_ns,p50_ns,p99_ns,p999_ns,qps
+// input_64.txt,64,linear_search,1000000,0.500,45.1,42.9,72.4,186.7,21355433
+// input_64.txt,64,binary_search,1000000,0.500,72.7,40.0,100.0,278.1,17216089
+// input_1024.txt,1024,linear_search,1000000,0.500,541.6,641.9,764.8,945.7,1737867
+// input_1024.txt,1024,binary_search,1000000,0.500,68.3,61.0,143.8,352.4,16890103
+// input_4096.txt,4096,linear_search,262144,0.500,2302.4,2158.1,3259.1,17949.8,484730
+// input_4096.txt,4096,binary_search,1000000,0.500,86.3,66.7,163.8,297.1,10585049
+// input_65536.txt,65536,linear_search,16384,0.497,31775.8,35810.1,55935.1,85992.7,30492
+// input_65536.txt,65536,binary_search,1000000,0.500,107.8,96.2,241.9,490.5,10469926
+// synthetic,65536,linear_search,16384,0.500,33224.4,40712.0,51418.9,149259.4,30047
+// synthetic,65536,binary_search,1000000,0.500,255.0,162.9,259.1,587.6,6127875
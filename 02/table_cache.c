@@ -0,0 +1,381 @@
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// binary_search.c と linear_search.c は scanf("%d") で 1 要素ずつ
+// 表を読み込むため、大きな表では読み込みが探索よりもずっと遅くなります。
+// このプログラムは input_*.txt を一度だけ高速に解析してバイナリの
+// キャッシュファイル (input_*.txt.bin) を作り、2 回目以降は mmap で
+// コピーせずにそのまま使います。
+//
+// 使い方:
+//   ./a.out input_64.txt input_1024.txt input_4096.txt input_65536.txt
+//   ./a.out -s 100000000   # 10^8 要素の synthetic_100000000.txt を作って計測
+
+// キャッシュファイルの先頭に置くヘッダです。
+// ヘッダの後ろに int32_t の昇順の配列が count 個そのまま続きます。
+#define CACHE_MAGIC "ALG1TBL"
+
+typedef struct {
+    char magic[8];
+    uint64_t count;
+    uint64_t checksum;
+    uint64_t reserved;
+} cache_header;
+
+typedef struct {
+    int32_t* table;
+    int length;
+    // mmap した場合は解放に munmap を使うため、領域全体を覚えておきます。
+    void* mapped;
+    size_t mapped_size;
+} loaded_table;
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// FNV-1a を 4 byte 単位にしたものです。壊れたファイルを検出できれば十分です。
+uint64_t checksum(const int32_t* table, int length) {
+    uint64_t h = 14695981039346656037ULL;
+    for (int i = 0; i < length; i++) {
+        h ^= (uint32_t)table[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+void free_table(loaded_table* t) {
+    if (t->mapped != NULL) {
+        munmap(t->mapped, t->mapped_size);
+    } else {
+        free(t->table);
+    }
+    t->table = NULL;
+    t->mapped = NULL;
+}
+
+// 元のプログラムと同じく scanf で読み込みます。比較用です。
+bool load_scanf(const char* path, loaded_table* t) {
+    FILE* fp = fopen(path, "r");
+    if (fp == NULL) {
+        return false;
+    }
+    int length;
+    if (fscanf(fp, "%d", &length) != 1) {
+        fclose(fp);
+        return false;
+    }
+    t->table = (int32_t*)malloc(length * sizeof(int32_t));
+    t->length = length;
+    t->mapped = NULL;
+    for (int i = 0; i < length; i++) {
+        if (fscanf(fp, "%d", &t->table[i]) != 1) {
+            fclose(fp);
+            free(t->table);
+            return false;
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+// テキストファイルを mmap して手書きのパーサで解析します。
+// 数字と '-' 以外の文字はすべて区切りとみなします。
+bool load_text(const char* path, loaded_table* t) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    const char* data = (const char*)mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+    madvise((void*)data, st.st_size, MADV_SEQUENTIAL);
+
+    const char* p = data;
+    const char* end = data + st.st_size;
+    int length = -1;
+    int count = 0;
+    t->table = NULL;
+    while (p < end) {
+        while (p < end && *p != '-' && (unsigned)(*p - '0') > 9) {
+            p++;
+        }
+        if (p == end) {
+            break;
+        }
+        bool negative = *p == '-';
+        if (negative) {
+            p++;
+        }
+        int64_t x = 0;
+        while (p < end && (unsigned)(*p - '0') <= 9) {
+            x = x * 10 + (*p - '0');
+            p++;
+        }
+        if (negative) {
+            x = -x;
+        }
+
+        // 最初の数が要素数です。
+        if (length < 0) {
+            length = (int)x;
+            t->table = (int32_t*)malloc(length * sizeof(int32_t));
+        } else if (count < length) {
+            t->table[count++] = (int32_t)x;
+        } else {
+            break;
+        }
+    }
+    munmap((void*)data, st.st_size);
+
+    if (length < 0 || count != length) {
+        free(t->table);
+        return false;
+    }
+    t->length = length;
+    t->mapped = NULL;
+    return true;
+}
+
+int compare_int32(const void* a, const void* b) {
+    int32_t x = *(const int32_t*)a;
+    int32_t y = *(const int32_t*)b;
+    return (x > y) - (x < y);
+}
+
+// 表をキャッシュファイルに書き出します。
+// キャッシュは二分探索にそのまま使えるように必ず昇順にします。
+// 入力が昇順でない場合は警告を出して並べ替えます。
+bool write_cache(const char* path, loaded_table* t) {
+    for (int i = 1; i < t->length; i++) {
+        if (t->table[i - 1] > t->table[i]) {
+            fprintf(stderr, "%s: the table is not sorted (index %d), sorting it\n", path, i);
+            qsort(t->table, t->length, sizeof(int32_t), compare_int32);
+            break;
+        }
+    }
+
+    cache_header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.count = t->length;
+    header.checksum = checksum(t->table, t->length);
+
+    // 書き込み途中のファイルを読まないように、一時ファイルに書いてから rename します。
+    char tmp_path[4096];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    FILE* fp = fopen(tmp_path, "wb");
+    if (fp == NULL) {
+        return false;
+    }
+    bool ok = fwrite(&header, sizeof(header), 1, fp) == 1 &&
+              fwrite(t->table, sizeof(int32_t), t->length, fp) == (size_t)t->length;
+    ok = fclose(fp) == 0 && ok;
+    if (!ok || rename(tmp_path, path) != 0) {
+        unlink(tmp_path);
+        return false;
+    }
+    return true;
+}
+
+// キャッシュファイルを mmap します。表はコピーせず、マップした領域を直接指します。
+// verify が true の場合はチェックサムも確認します (全要素を読むことになります)。
+bool map_cache(const char* path, loaded_table* t, bool verify) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(cache_header)) {
+        close(fd);
+        return false;
+    }
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return false;
+    }
+
+    const cache_header* header = (const cache_header*)data;
+    bool ok = memcmp(header->magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) == 0 &&
+              sizeof(cache_header) + header->count * sizeof(int32_t) == (size_t)st.st_size;
+    t->table = (int32_t*)((char*)data + sizeof(cache_header));
+    t->length = ok ? (int)header->count : 0;
+    if (ok && verify) {
+        ok = checksum(t->table, t->length) == header->checksum;
+    }
+    if (!ok) {
+        munmap(data, st.st_size);
+        return false;
+    }
+    t->mapped = data;
+    t->mapped_size = st.st_size;
+    return true;
+}
+
+// キャッシュがテキストより新しければ mmap し、そうでなければ
+// テキストを解析してキャッシュを作り直します。
+bool load_table(const char* path, loaded_table* t) {
+    char cache_path[4096];
+    snprintf(cache_path, sizeof(cache_path), "%s.bin", path);
+
+    struct stat text_st, cache_st;
+    if (stat(path, &text_st) == 0 && stat(cache_path, &cache_st) == 0 &&
+        cache_st.st_mtime >= text_st.st_mtime && map_cache(cache_path, t, false)) {
+        return true;
+    }
+    if (!load_text(path, t)) {
+        return false;
+    }
+    write_cache(cache_path, t);
+    return true;
+}
+
+// 計測用に 0, 3, 6, ... と並んだ count 要素のテキストファイルを作ります。
+void generate(const char* path, int count) {
+    FILE* fp = fopen(path, "w");
+    fprintf(fp, "%d\n\n", count);
+    for (int i = 0; i < count; i++) {
+        fprintf(fp, "%d\n", i * 3);
+    }
+    fclose(fp);
+}
+
+void benchmark(const char* path) {
+    char cache_path[4096];
+    snprintf(cache_path, sizeof(cache_path), "%s.bin", path);
+    loaded_table t;
+
+    printf("%s\n", path);
+    double start = now();
+    if (!load_scanf(path, &t)) {
+        printf("  failed to load\n");
+        return;
+    }
+    printf("  scanf         : %.6lf s\n", now() - start);
+    free_table(&t);
+
+    start = now();
+    if (!load_text(path, &t)) {
+        printf("  failed to load\n");
+        return;
+    }
+    printf("  fast parser   : %.6lf s (%d elements)\n", now() - start, t.length);
+
+    start = now();
+    if (!write_cache(cache_path, &t)) {
+        printf("  failed to write the cache\n");
+        free_table(&t);
+        return;
+    }
+    printf("  write cache   : %.6lf s\n", now() - start);
+    int64_t expected = 0;
+    for (int i = 0; i < t.length; i++) {
+        expected += t.table[i];
+    }
+    free_table(&t);
+
+    start = now();
+    if (!map_cache(cache_path, &t, false)) {
+        printf("  failed to map the cache\n");
+        return;
+    }
+    printf("  mmap          : %.6lf s\n", now() - start);
+    int64_t sum = 0;
+    for (int i = 0; i < t.length; i++) {
+        sum += t.table[i];
+    }
+    printf("  mmap + touch  : %.6lf s%s\n", now() - start, sum == expected ? "" : " (MISMATCH)");
+    free_table(&t);
+
+    start = now();
+    if (map_cache(cache_path, &t, true)) {
+        printf("  mmap + verify : %.6lf s\n", now() - start);
+        free_table(&t);
+    } else {
+        printf("  mmap + verify : BROKEN\n");
+    }
+
+    start = now();
+    if (load_table(path, &t)) {
+        printf("  load_table    : %.6lf s\n", now() - start);
+        free_table(&t);
+    }
+}
+
+int main(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            char path[64];
+            int count = atoi(argv[++i]);
+            snprintf(path, sizeof(path), "synthetic_%d.txt", count);
+            generate(path, count);
+            benchmark(path);
+        } else {
+            benchmark(argv[i]);
+        }
+    }
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// $ ./a.out input_64.txt input_1024.txt input_4096.txt input_65536.txt
+// input_64.txt
+//   scanf         : 0.000041 s
+//   fast parser   : 0.000016 s (64 elements)
+//   write cache   : 0.000061 s
+//   mmap          : 0.000029 s
+//   mmap + touch  : 0.000031 s
+//   mmap + verify : 0.000006 s
+//   load_table    : 0.000008 s
+// input_1024.txt
+//   scanf         : 0.000119 s
+//   fast parser   : 0.000022 s (1024 elements)
+//   write cache   : 0.000037 s
+//   mmap          : 0.000006 s
+//   mmap + touch  : 0.000008 s
+//   mmap + verify : 0.000007 s
+//   load_table    : 0.000008 s
+// input_4096.txt
+//   scanf         : 0.000535 s
+//   fast parser   : 0.000073 s (4096 elements)
+//   write cache   : 0.000064 s
+//   mmap          : 0.000008 s
+//   mmap + touch  : 0.000013 s
+//   mmap + verify : 0.000015 s
+//   load_table    : 0.000011 s
+// input_65536.txt
+//   scanf         : 0.005667 s
+//   fast parser   : 0.000696 s (65536 elements)
+// input_65536.txt.bin: the table is not sorted (index 18), sorting it
+//   write cache   : 0.002289 s
+//   mmap          : 0.000010 s
+//   mmap + touch  : 0.000048 s
+//   mmap + verify : 0.000097 s
+//   load_table    : 0.000007 s
+// $ ./a.out -s 100000000
+// synthetic_100000000.txt
+//   scanf         : 8.409477 s
+//   fast parser   : 1.119388 s (100000000 elements)
+//   write cache   : 0.597884 s
+//   mmap          : 0.000085 s
+//   mmap + touch  : 0.072079 s
+//   mmap + verify : 0.139120 s
+//   load_table    : 0.000047 s
@@ -0,0 +1,338 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 時間計測をする際には大きな数値にしてください。
+#define MAX_OPERATIONS 100000
+// 1 回の操作で最大 length 個の要素をずらすため、
+// length * 操作回数がこの値を超えないように操作回数を減らします。
+#define MOVE_BUDGET 1000000000LL
+#define MAX_LENGTH 10000000
+// insert_range で一度に挿入する要素数です。
+#define BATCH 64
+
+// array.c の sequence は要素数が SIZE で固定されていて、insert と erase は
+// 要素を 1 つずつ C のループでずらしています。この sequence は
+// 1. 要素をヒープに確保し、足りなくなったら容量を 2 倍にします
+//    (push を n 回しても realloc は log n 回、コピーは合計 2n 要素以下です)。
+// 2. 要素をずらすのに memmove を使います。memmove は SIMD で
+//    まとめてコピーするため、1 要素ずつの C のループより速くなります
+//    (後述の insert_loop も参照してください)。
+// 3. insert_range と erase_range で、複数の要素を挿入・削除するときに
+//    後ろの要素を 1 回だけずらします。
+//
+// gap_mode が true の場合はギャップバッファとして動作します。
+// 空き領域 (ギャップ) を末尾ではなく最後に編集した位置に置いておき、
+// 要素は elements[0 .. gap) と elements[gap + 空き容量 .. capacity) に
+// 分かれて入ります。同じ場所の近くで編集を繰り返す場合 (テキストエディタの
+// カーソル位置での入力など) は、ギャップを前回の位置から今回の位置まで
+// 動かすだけで済むため、ずらす要素の数は位置の差だけになります。
+// gap_mode が false の場合は常に gap == length (ギャップは末尾) です。
+typedef struct {
+    int* elements;
+    int length;
+    int capacity;
+    int gap;
+    bool gap_mode;
+} sequence;
+
+void init(sequence* seq, bool gap_mode) {
+    seq->elements = NULL;
+    seq->length = 0;
+    seq->capacity = 0;
+    seq->gap = 0;
+    seq->gap_mode = gap_mode;
+}
+
+void destroy(sequence* seq) {
+    free(seq->elements);
+    init(seq, seq->gap_mode);
+}
+
+// ギャップより後ろにある要素の数です。
+static inline int back_length(const sequence* seq) {
+    return seq->length - seq->gap;
+}
+
+// 少なくとも needed 個の要素が入るように容量を増やします。
+// ギャップより後ろの要素は新しい領域の末尾に移します。
+void reserve(sequence* seq, int needed) {
+    if (needed <= seq->capacity) {
+        return;
+    }
+    int capacity = seq->capacity < 16 ? 16 : seq->capacity;
+    while (capacity < needed) {
+        capacity *= 2;
+    }
+    int back = back_length(seq);
+    int* elements = (int*)realloc(seq->elements, (size_t)capacity * sizeof(int));
+    assert(elements != NULL);
+    memmove(elements + capacity - back, elements + seq->capacity - back, (size_t)back * sizeof(int));
+    seq->elements = elements;
+    seq->capacity = capacity;
+}
+
+// ギャップを pos に動かします。pos と今のギャップの間にある要素だけをずらします。
+void move_gap(sequence* seq, int pos) {
+    int free_space = seq->capacity - seq->length;
+    if (pos < seq->gap) {
+        memmove(seq->elements + pos + free_space, seq->elements + pos, (size_t)(seq->gap - pos) * sizeof(int));
+    } else if (pos > seq->gap) {
+        memmove(seq->elements + seq->gap, seq->elements + seq->gap + free_space,
+                (size_t)(pos - seq->gap) * sizeof(int));
+    }
+    seq->gap = pos;
+}
+
+int get(const sequence* seq, int pos) {
+    assert(0 <= pos && pos < seq->length);
+    return pos < seq->gap ? seq->elements[pos] : seq->elements[pos + seq->capacity - seq->length];
+}
+
+// values[0 .. count) を pos の位置に挿入します。
+void insert_range(sequence* seq, int pos, const int* values, int count) {
+    assert(0 <= pos && pos <= seq->length);
+    reserve(seq, seq->length + count);
+    if (seq->gap_mode) {
+        move_gap(seq, pos);
+        memcpy(seq->elements + pos, values, (size_t)count * sizeof(int));
+        seq->gap += count;
+    } else {
+        memmove(seq->elements + pos + count, seq->elements + pos, (size_t)(seq->length - pos) * sizeof(int));
+        memcpy(seq->elements + pos, values, (size_t)count * sizeof(int));
+        seq->gap += count;
+    }
+    seq->length += count;
+}
+
+// pos から count 個の要素を削除します。
+void erase_range(sequence* seq, int pos, int count) {
+    assert(0 <= pos && 0 <= count && pos + count <= seq->length);
+    if (seq->gap_mode) {
+        // ギャップを pos に動かし、その直後の count 個をギャップに含めます。
+        move_gap(seq, pos);
+    } else {
+        memmove(seq->elements + pos, seq->elements + pos + count,
+                (size_t)(seq->length - pos - count) * sizeof(int));
+        seq->gap -= count;
+    }
+    seq->length -= count;
+}
+
+void insert(sequence* seq, int pos, int val) {
+    insert_range(seq, pos, &val, 1);
+}
+
+// delete は C++ の予約語なので、念のため erase と書きます
+void erase(sequence* seq, int pos) {
+    erase_range(seq, pos, 1);
+}
+
+void push_back(sequence* seq, int val) {
+    insert(seq, seq->length, val);
+}
+
+void print(sequence* seq) {
+    printf("ELEMENTS: [ ");
+    for (int i = 0; i < seq->length; i++) {
+        printf("%d ", get(seq, i));
+    }
+    printf("]\n");
+    printf("LENGTH  : %d\n", seq->length);
+}
+
+// 比較用に、array.c の insert と erase と同じく要素を 1 つずつずらすものです。
+// gap_mode が false の sequence に使います。
+// なお gcc -O2 はこのような単純なコピーのループを memmove の呼び出しに
+// 置き換えるため (-ftree-loop-distribute-patterns)、実行結果では memmove と
+// ほぼ同じ時間になっています。-fno-tree-loop-distribute-patterns を付けると
+// 10^7 要素で 3 倍程度遅くなります。
+void insert_loop(sequence* seq, int pos, int val) {
+    reserve(seq, seq->length + 1);
+    for (int i = seq->length - 1; i >= pos; i--) {
+        seq->elements[i + 1] = seq->elements[i];
+    }
+    seq->length++;
+    seq->gap++;
+    seq->elements[pos] = val;
+}
+
+void erase_loop(sequence* seq, int pos) {
+    seq->length--;
+    seq->gap--;
+    for (int i = pos; i < seq->length; i++) {
+        seq->elements[i] = seq->elements[i + 1];
+    }
+}
+
+// 入力を作るために用意した本題とは関係ない関数です。
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+// 編集する位置の列を作ります。
+// clustered が false ならば一様な乱数、true ならば前回の位置の前後 8 以内です。
+void make_positions(int* positions, int num_operations, int length, bool clustered) {
+    uint64_t state = 88172645463325252ULL;
+    int pos = length / 2;
+    for (int i = 0; i < num_operations; i++) {
+        uint64_t r = xorshift64(&state);
+        if (clustered) {
+            pos += (int)(r % 17) - 8;
+            pos = pos < 0 ? 0 : pos >= length ? length - 1 : pos;
+        } else {
+            pos = (int)(r % length);
+        }
+        positions[i] = pos;
+    }
+}
+
+void fill(sequence* seq, int length) {
+    for (int i = 0; i < length; i++) {
+        push_back(seq, i);
+    }
+}
+
+// 1 回の操作 (挿入 1 回と削除 1 回) あたりの時間 (ns) を返します。
+double time_edits(int length, const int* positions, int num_operations, int method) {
+    sequence seq;
+    init(&seq, method == 2);
+    fill(&seq, length);
+    long start_clock = clock();
+    for (int i = 0; i < num_operations; i++) {
+        if (method == 0) {
+            insert_loop(&seq, positions[i], i);
+            erase_loop(&seq, positions[i]);
+        } else {
+            insert(&seq, positions[i], i);
+            erase(&seq, positions[i]);
+        }
+    }
+    double t = (double)(clock() - start_clock) / CLOCKS_PER_SEC * 1e9 / num_operations;
+    assert(seq.length == length);
+    destroy(&seq);
+    return t;
+}
+
+// BATCH 個の要素をまとめて挿入・削除する 1 回あたりの時間 (ns) を返します。
+double time_batches(int length, const int* positions, int num_operations, bool use_range) {
+    int values[BATCH];
+    for (int i = 0; i < BATCH; i++) {
+        values[i] = -i;
+    }
+    sequence seq;
+    init(&seq, false);
+    fill(&seq, length);
+    long start_clock = clock();
+    for (int i = 0; i < num_operations; i++) {
+        if (use_range) {
+            insert_range(&seq, positions[i], values, BATCH);
+            erase_range(&seq, positions[i], BATCH);
+        } else {
+            for (int j = 0; j < BATCH; j++) {
+                insert(&seq, positions[i] + j, values[j]);
+            }
+            for (int j = 0; j < BATCH; j++) {
+                erase(&seq, positions[i]);
+            }
+        }
+    }
+    double t = (double)(clock() - start_clock) / CLOCKS_PER_SEC * 1e9 / num_operations;
+    assert(seq.length == length);
+    destroy(&seq);
+    return t;
+}
+
+int main() {
+    // array.c と同じ操作を、両方のモードで確認します。
+    for (int mode = 0; mode < 2; mode++) {
+        sequence seq;
+        init(&seq, mode == 1);
+        for (int i = 0; i < 10; i++) {
+            insert(&seq, i, i);
+        }
+        print(&seq);
+
+        erase(&seq, 5);
+        print(&seq);
+
+        int values[] = {100, 101, 102};
+        insert_range(&seq, 2, values, 3);
+        erase_range(&seq, 7, 2);
+        print(&seq);
+        destroy(&seq);
+    }
+
+    // 挿入と削除の時間 (ns / 操作)
+    // loop: array.c と同じ 1 要素ずつのループ, memmove: memmove でずらす,
+    // gap: ギャップバッファ
+    int* positions = (int*)malloc(MAX_OPERATIONS * sizeof(int));
+    printf("\n%9s %7s %28s %28s\n", "", "", "random", "clustered");
+    printf("%9s %7s %9s %9s %9s %9s %9s %9s\n", "length", "ops", "loop", "memmove", "gap", "loop", "memmove",
+           "gap");
+    for (int length = 1000; length <= MAX_LENGTH; length *= 10) {
+        long long budget = MOVE_BUDGET / length;
+        int num_operations = budget < MAX_OPERATIONS ? (int)budget : MAX_OPERATIONS;
+        printf("%9d %7d", length, num_operations);
+        for (int clustered = 0; clustered < 2; clustered++) {
+            make_positions(positions, num_operations, length, clustered);
+            for (int method = 0; method < 3; method++) {
+                printf(" %9.1lf", time_edits(length, positions, num_operations, method));
+            }
+        }
+        printf("\n");
+    }
+
+    // BATCH 個の要素の挿入と削除 (ns / 回)
+    printf("\n%9s %7s %12s %12s\n", "length", "ops", "one by one", "range");
+    for (int length = 1000; length <= MAX_LENGTH; length *= 10) {
+        long long budget = MOVE_BUDGET / length / BATCH;
+        int num_operations = budget < MAX_OPERATIONS ? (int)budget : MAX_OPERATIONS;
+        num_operations = num_operations < 1 ? 1 : num_operations;
+        make_positions(positions, num_operations, length, false);
+        printf("%9d %7d %12.1lf %12.1lf\n", length, num_operations,
+               time_batches(length, positions, num_operations, false),
+               time_batches(length, positions, num_operations, true));
+    }
+    free(positions);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// ELEMENTS: [ 0 1 2 3 4 5 6 7 8 9 ]
+// LENGTH  : 10
+// ELEMENTS: [ 0 1 2 3 4 6 7 8 9 ]
+// LENGTH  : 9
+// ELEMENTS: [ 0 1 100 101 102 2 3 7 8 9 ]
+// LENGTH  : 10
+// ELEMENTS: [ 0 1 2 3 4 5 6 7 8 9 ]
+// LENGTH  : 10
+// ELEMENTS: [ 0 1 2 3 4 6 7 8 9 ]
+// LENGTH  : 9
+// ELEMENTS: [ 0 1 100 101 102 2 3 7 8 9 ]
+// LENGTH  : 10
+//
+//                                         random                    clustered
+//    length     ops      loop   memmove       gap      loop   memmove       gap
+//      1000  100000      45.9      48.2      35.6      41.6      43.2      29.7
+//     10000  100000     286.8     296.1     159.4     314.1     312.9      28.0
+//    100000   10000    7118.9    7515.7    3494.6    7198.9    6998.1      28.4
+//   1000000    1000  105126.0  104831.0   40540.0   86787.0   88897.0     107.0
+//  10000000     100 1690400.0 1754270.0 1407790.0 1709810.0 1695750.0  140090.0
+//
+//    length     ops   one by one        range
+//      1000   15625       3159.9         58.4
+//     10000    1562      18902.0        281.0
+//    100000     156     538878.2       7012.8
+//   1000000      15    8940866.7     125333.3
+//  10000000       1  107314000.0    2835000.0
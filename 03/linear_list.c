@@ -1,6 +1,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "pool_allocator.h"
+
 // この構造体ではメンバにこの構造体自身を持たせる必要があります。
 // いままでのように typedef struct {} name; と書くと、メンバ
 // 宣言時点で構造体の名前が存在しないため定義できません。よって
@@ -11,6 +13,18 @@ typedef struct cell_ {
     struct cell_* next;
 } cell;
 
+// cell は malloc ではなく、cell と同じ大きさのオブジェクトだけを扱うプールから確保します。
+// 解放した cell はプールに戻り、次の new_cell で使い回されます (pool_allocator.h)。
+pool cell_pool;
+
+cell* new_cell() {
+    return (cell*)pool_alloc(&cell_pool);
+}
+
+void delete_cell(cell* c) {
+    pool_free(&cell_pool, c);
+}
+
 // 講義スライドでは list は cell* の別名ですが、このコードでは
 // 別の構造体としているため注意してください。別名としてしまうと
 // head のポインタ自体を変更する操作で pointer to pointer と
@@ -26,21 +40,21 @@ void clear(list* l) {
     cell* current = l->head;
     while (current != NULL) {
         cell* next = current->next;
-        free(current);
+        delete_cell(current);
         current = next;
     }
     l->head = NULL;
 }
 
 void insert(cell* previous, int val) {
-    cell* c = (cell*)malloc(sizeof(cell));
+    cell* c = new_cell();
     c->element = val;
     c->next = previous->next;
     previous->next = c;
 }
 
 void insert_head(list* l, int val) {
-    cell* c = (cell*)malloc(sizeof(cell));
+    cell* c = new_cell();
     c->element = val;
     c->next = l->head;
     l->head = c;
@@ -49,13 +63,13 @@ void insert_head(list* l, int val) {
 void erase(cell* previous) {
     cell* target = previous->next;
     previous->next = target->next;
-    free(target);
+    delete_cell(target);
 }
 
 void erase_head(list* l) {
     cell* target = l->head;
     l->head = target->next;
-    free(target);
+    delete_cell(target);
 }
 
 void print(list* l) {
@@ -69,6 +83,7 @@ void print(list* l) {
 }
 
 int main() {
+    pool_init(&cell_pool, sizeof(cell), OBJECTS_PER_SLAB);
     list l = {NULL};
 
     cell* c;
@@ -91,6 +106,7 @@ int main() {
     clear(&l);
     print(&l);
 
+    pool_destroy(&cell_pool);
     return 0;
 }
 
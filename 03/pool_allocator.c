@@ -0,0 +1,511 @@
+#include <assert.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define HAS_PERF_EVENT 1
+#else
+#define HAS_PERF_EVENT 0
+#endif
+
+#include "../05/string_arena.h"
+#include "pool_allocator.h"
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_OPERATIONS 10000000
+#define LIST_LENGTH 1000000
+#define TABLE_LENGTH 1000
+#define NUM_THREADS 4
+
+// 03/linear_list.c, 04/stack_list.c, 04/queue_list.c,
+// 05/linear_search_list.c は要素を 1 つ追加するたびに malloc を、
+// 1 つ削除するたびに free を呼び出していました。
+// malloc と free はどんな大きさの要求にも応えられるように作られているため
+// 1 回ごとの処理が重く、また確保された領域がメモリ上に散らばることがあります。
+//
+// ここでは同じ大きさのオブジェクトだけを扱うプール (スラブ) アロケータを作ります。
+// 1. まとめて大きな領域 (スラブ) を確保し、それをオブジェクトの大きさに区切って使います。
+// 2. 空いているオブジェクトは、そのオブジェクト自身の先頭に次の空きへのポインタを
+//    書き込んだ連結リスト (intrusive free list) でつなぎます。管理用の領域は不要で、
+//    確保も解放もリストの先頭を付け替えるだけです。
+// 3. 同じスラブから順番に切り出すので、続けて確保したオブジェクトは
+//    メモリ上で隣り合い、キャッシュに乗りやすくなります。
+//
+// プールは pool_allocator.h にあり、上の 4 つのモジュールはそれを include して
+// new_cell / delete_cell (05/linear_search_list.c は new_record / delete_record) を通して使います。
+// このファイルでは同じモジュールの写しを malloc 版とプール版で切り替えて比べます。
+
+// ここから下は計測のための各モジュールの写しです。
+// use_pool が false ならばプールを使う前のコードと同じく malloc と free を、
+// true ならばプールを使います (計測で比べるために切り替えられるようにしています)。
+// 複数のスレッドから使う場合はスレッドごとのキャッシュを通します。
+bool use_pool = false;
+bool use_cache = false;
+_Thread_local pool_cache cell_cache = {NULL, 0};
+
+// 03/linear_list.c, 04/stack_list.c, 04/queue_list.c の cell です。
+typedef struct cell_ {
+    int element;
+    struct cell_* next;
+} cell;
+
+pool cell_pool;
+
+cell* new_cell() {
+    if (!use_pool) {
+        return (cell*)malloc(sizeof(cell));
+    }
+    return (cell*)(use_cache ? cache_alloc(&cell_pool, &cell_cache) : pool_alloc(&cell_pool));
+}
+
+void delete_cell(cell* c) {
+    if (!use_pool) {
+        free(c);
+    } else if (use_cache) {
+        cache_free(&cell_pool, &cell_cache, c);
+    } else {
+        pool_free(&cell_pool, c);
+    }
+}
+
+// 05/linear_search_list.c の record です。value の文字列は values に置きます (05/string_arena.h)。
+string_arena values;
+
+typedef struct record_ {
+    int key;
+    string_ref value;
+    struct record_* next;
+} record;
+
+pool record_pool;
+
+record* new_record() {
+    return use_pool ? (record*)pool_alloc(&record_pool) : (record*)malloc(sizeof(record));
+}
+
+void delete_record(record* rec) {
+    if (use_pool) {
+        pool_free(&record_pool, rec);
+    } else {
+        free(rec);
+    }
+}
+
+// 03/linear_list.c の list です。malloc と free を new_cell と delete_cell に置き換えています。
+typedef struct {
+    cell* head;
+} list;
+
+void list_clear(list* l) {
+    cell* current = l->head;
+    while (current != NULL) {
+        cell* next = current->next;
+        delete_cell(current);
+        current = next;
+    }
+    l->head = NULL;
+}
+
+void list_insert(cell* previous, int val) {
+    cell* c = new_cell();
+    c->element = val;
+    c->next = previous->next;
+    previous->next = c;
+}
+
+void list_insert_head(list* l, int val) {
+    cell* c = new_cell();
+    c->element = val;
+    c->next = l->head;
+    l->head = c;
+}
+
+void list_erase(cell* previous) {
+    cell* target = previous->next;
+    previous->next = target->next;
+    delete_cell(target);
+}
+
+// 04/stack_list.c の stack です。
+typedef struct {
+    cell* head;
+} stack;
+
+void push(stack* s, int val) {
+    cell* c = new_cell();
+    c->element = val;
+    c->next = s->head;
+    s->head = c;
+}
+
+int pop(stack* s) {
+    assert(s->head != NULL);
+
+    int val = s->head->element;
+    cell* c = s->head;
+    s->head = s->head->next;
+    delete_cell(c);
+    return val;
+}
+
+// 04/queue_list.c の queue です。
+typedef struct {
+    cell* head;
+    cell* tail;
+} queue;
+
+bool empty(queue* que) {
+    return que->head == NULL;
+}
+
+void enqueue(queue* que, int val) {
+    cell* c = new_cell();
+    c->element = val;
+    c->next = NULL;
+
+    if (empty(que)) {
+        que->head = c;
+    } else {
+        que->tail->next = c;
+    }
+    que->tail = c;
+}
+
+int dequeue(queue* que) {
+    assert(!empty(que));
+
+    int val = que->head->element;
+    cell* c = que->head;
+    que->head = que->head->next;
+    delete_cell(c);
+    return val;
+}
+
+// 05/linear_search_list.c の table です。
+typedef struct {
+    record* header;
+    record* sentinel;
+} table;
+
+record* init_record(int key, const char* value) {
+    record* rec = new_record();
+    rec->next = NULL;
+    rec->key = key;
+    rec->value = arena_store(&values, value);
+    return rec;
+}
+
+void table_clear(table* tab) {
+    record* current = tab->header->next;
+    while (current != tab->sentinel) {
+        record* next = current->next;
+        delete_record(current);
+        current = next;
+    }
+
+    delete_record(tab->header);
+    delete_record(tab->sentinel);
+    tab->header = NULL;
+    tab->sentinel = NULL;
+}
+
+record* search_previous(table* tab, int target) {
+    tab->sentinel->key = target;
+    record* previous = tab->header;
+    record* current = tab->header->next;
+    while (target != current->key) {
+        previous = current;
+        current = current->next;
+    }
+    bool found = current != tab->sentinel;
+    return found ? previous : NULL;
+}
+
+void table_insert_head(table* tab, record* rec) {
+    rec->next = tab->header->next;
+    tab->header->next = rec;
+}
+
+void erase_next(record* previous) {
+    record* current = previous->next;
+    previous->next = current->next;
+    delete_record(current);
+}
+
+// 計測のための関数です。
+// ハードウェアのキャッシュミスの回数は perf_event_open で数えます。
+// 仮想マシンなどで使えない場合は -1 を返します。
+int open_cache_miss_counter() {
+#if HAS_PERF_EVENT
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    return -1;
+#endif
+}
+
+void start_counter(int fd) {
+#if HAS_PERF_EVENT
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+#else
+    (void)fd;
+#endif
+}
+
+long long stop_counter(int fd) {
+#if HAS_PERF_EVENT
+    long long count;
+    if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        if (read(fd, &count, sizeof(count)) == sizeof(count)) {
+            return count;
+        }
+    }
+#else
+    (void)fd;
+#endif
+    return -1;
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 入力を作るために用意した本題とは関係ない関数です。
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+// 各ワークロードは実行した操作の数を返します。
+// 答えの検算のため、取り出した値などの合計を *checksum に足します。
+
+// stack: 1000 個 push して 1000 個 pop することを繰り返します。
+long long run_stack(long long* checksum) {
+    stack s = {NULL};
+    for (int round = 0; round < NUM_OPERATIONS / 2000; round++) {
+        for (int i = 0; i < 1000; i++) {
+            push(&s, i);
+        }
+        for (int i = 0; i < 1000; i++) {
+            *checksum += pop(&s);
+        }
+    }
+    return NUM_OPERATIONS / 2000 * 2000;
+}
+
+// queue: 1000 個入れた状態で enqueue と dequeue を交互に行います。
+long long run_queue(long long* checksum) {
+    queue q = {NULL, NULL};
+    for (int i = 0; i < 1000; i++) {
+        enqueue(&q, i);
+    }
+    for (int i = 0; i < NUM_OPERATIONS / 2; i++) {
+        enqueue(&q, i);
+        *checksum += dequeue(&q);
+    }
+    while (!empty(&q)) {
+        *checksum += dequeue(&q);
+    }
+    return NUM_OPERATIONS / 2 * 2;
+}
+
+// list: 要素の挿入と削除をランダムな位置で繰り返して並びをかき混ぜてから、
+// リストを何度もたどります。たどる速さは cell がメモリ上でどれだけ
+// まとまっているかで決まります。
+long long run_list(long long* checksum) {
+    list l = {NULL};
+    uint64_t state = 88172645463325252ULL;
+    for (int i = 0; i < LIST_LENGTH; i++) {
+        list_insert_head(&l, i);
+        // ときどき先頭から 64 個以内の cell の後ろで削除と挿入をします。
+        if (xorshift64(&state) % 4 == 0) {
+            cell* previous = l.head;
+            for (int steps = (int)(xorshift64(&state) % 64); steps > 0 && previous->next != NULL; steps--) {
+                previous = previous->next;
+            }
+            if (previous->next != NULL) {
+                list_erase(previous);
+                list_insert(previous, i);
+            }
+        }
+    }
+    long long operations = LIST_LENGTH;
+    for (int pass = 0; pass < 10; pass++) {
+        for (cell* current = l.head; current != NULL; current = current->next) {
+            *checksum += current->element;
+            operations++;
+        }
+    }
+    list_clear(&l);
+    return operations;
+}
+
+// table: TABLE_LENGTH 個の record を持つ表で、ランダムな key を探して
+// 削除し、同じ key の record を先頭に挿入し直すことを繰り返します。
+long long run_table(long long* checksum) {
+    table tab;
+    tab.header = init_record(-1, "");
+    tab.sentinel = init_record(-1, "");
+    tab.header->next = tab.sentinel;
+    for (int i = 0; i < TABLE_LENGTH; i++) {
+        table_insert_head(&tab, init_record(i, "AAA"));
+    }
+    uint64_t state = 88172645463325252ULL;
+    int num_operations = NUM_OPERATIONS / TABLE_LENGTH * 10;
+    for (int i = 0; i < num_operations; i++) {
+        int key = (int)(xorshift64(&state) % TABLE_LENGTH);
+        record* previous = search_previous(&tab, key);
+        assert(previous != NULL);
+        *checksum += previous->next->key;
+        erase_next(previous);
+        table_insert_head(&tab, init_record(key, "BBB"));
+    }
+    table_clear(&tab);
+    return num_operations;
+}
+
+typedef struct {
+    const char* name;
+    long long (*run)(long long*);
+} workload;
+
+void benchmark(const workload* w, int counter) {
+    long long checksums[2];
+    printf("%-18s", w->name);
+    for (int mode = 0; mode < 2; mode++) {
+        use_pool = mode == 1;
+        pool_init(&cell_pool, sizeof(cell), OBJECTS_PER_SLAB);
+        pool_init(&record_pool, sizeof(record), OBJECTS_PER_SLAB);
+        checksums[mode] = 0;
+
+        start_counter(counter);
+        double start = now();
+        long long operations = w->run(&checksums[mode]);
+        double elapsed = now() - start;
+        long long misses = stop_counter(counter);
+
+        printf(" %14.0lf", operations / elapsed);
+        if (misses >= 0) {
+            printf(" %12lld", misses);
+        } else {
+            printf(" %12s", "n/a");
+        }
+        pool_destroy(&cell_pool);
+        pool_destroy(&record_pool);
+    }
+    printf("\n");
+    assert(checksums[0] == checksums[1]);
+}
+
+// 複数のスレッドで stack を使います。スタックはスレッドごとですが、
+// cell は 1 つの共有のプールから (スレッドごとのキャッシュを通して) 確保します。
+void* thread_main(void* arg) {
+    long long* checksum = (long long*)arg;
+    run_stack(checksum);
+    if (use_pool) {
+        cache_flush(&cell_pool, &cell_cache);
+    }
+    return NULL;
+}
+
+double benchmark_threads(bool pool_mode) {
+    use_pool = pool_mode;
+    use_cache = pool_mode;
+    pool_init(&cell_pool, sizeof(cell), OBJECTS_PER_SLAB);
+    pthread_t threads[NUM_THREADS];
+    long long checksums[NUM_THREADS] = {0};
+    double start = now();
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_create(&threads[i], NULL, thread_main, &checksums[i]);
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now() - start;
+    for (int i = 1; i < NUM_THREADS; i++) {
+        assert(checksums[i] == checksums[0]);
+    }
+    pool_destroy(&cell_pool);
+    use_cache = false;
+    return (double)NUM_THREADS * (NUM_OPERATIONS / 2000 * 2000) / elapsed;
+}
+
+int main() {
+    // 小さな例で、続けて確保した cell が隣り合うことを確認します。
+    pool_init(&cell_pool, sizeof(cell), 8);
+    cell* a = (cell*)pool_alloc(&cell_pool);
+    cell* b = (cell*)pool_alloc(&cell_pool);
+    printf("object size: %zu, b - a = %td bytes\n", cell_pool.object_size, (char*)b - (char*)a);
+    pool_free(&cell_pool, a);
+    cell* c = (cell*)pool_alloc(&cell_pool);
+    printf("freed object reused: %s\n", c == a ? "Yes" : "No");
+    for (int i = 0; i < 20; i++) {
+        pool_alloc(&cell_pool);
+    }
+    printf("slabs after 22 allocations: %d\n", cell_pool.num_slabs);
+    pool_destroy(&cell_pool);
+
+    int counter = open_cache_miss_counter();
+    workload workloads[] = {
+        {"stack (04)", run_stack},
+        {"queue (04)", run_queue},
+        {"list (03)", run_list},
+        {"table (05)", run_table},
+    };
+    printf("\n%-18s %14s %12s %14s %12s\n", "", "malloc ops/s", "misses", "pool ops/s", "misses");
+    for (int i = 0; i < 4; i++) {
+        benchmark(&workloads[i], counter);
+    }
+#if HAS_PERF_EVENT
+    if (counter >= 0) {
+        close(counter);
+    }
+#endif
+
+    printf("\n%d threads (stack)  malloc %.0lf ops/s, pool + thread cache %.0lf ops/s\n", NUM_THREADS,
+           benchmark_threads(false), benchmark_threads(true));
+
+    arena_clear(&values);
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// 仮想マシン上で実行したため、ハードウェアのキャッシュミスは数えられませんでした (n/a)。
+// table (05) は 1 回の操作の時間のほとんどが線形探索なので、プールにしてもほとんど変わりません。
+// object size: 16, b - a = 16 bytes
+// freed object reused: Yes
+// slabs after 22 allocations: 3
+//
+//                      malloc ops/s       misses     pool ops/s       misses
+// stack (04)               95841192          n/a      305631692          n/a
+// queue (04)              127420960          n/a      602548297          n/a
+// list (03)               109929663          n/a      235930231          n/a
+// table (05)                1050300          n/a        1079242          n/a
+//
+// 4 threads (stack)  malloc 52143638 ops/s, pool + thread cache 187453560 ops/s
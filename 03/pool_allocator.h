@@ -0,0 +1,158 @@
+#ifndef POOL_ALLOCATOR_H
+#define POOL_ALLOCATOR_H
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+
+// 同じ大きさのオブジェクトだけを扱うプール (スラブ) アロケータです。
+// 03/pool_allocator.c で説明と計測をしています。
+// 03/linear_list.c, 04/stack_list.c, 04/queue_list.c, 05/linear_search_list.c は、
+// このファイルを相対パスで include して、cell や record を malloc と free の代わりにプールから確保します。
+
+// 1 つのスラブに入れるオブジェクトの数です。
+#define OBJECTS_PER_SLAB 4096
+// スレッドごとのキャッシュと共有のプールの間で一度に移すオブジェクトの数です。
+#define CACHE_BATCH 64
+
+typedef struct free_object_ {
+    struct free_object_* next;
+} free_object;
+
+// スラブの先頭には、すべてのスラブをつなぐリストのためのヘッダを置きます。
+// オブジェクトはヘッダの後ろ、64 byte 境界から並べます。
+typedef struct slab_ {
+    struct slab_* next;
+} slab;
+
+#define SLAB_HEADER_SIZE 64
+
+typedef struct {
+    size_t object_size;
+    int objects_per_slab;
+    slab* slabs;
+    free_object* free_list;
+    int num_slabs;
+    // pool_cache から使う場合のためのロックです。
+    // pool_alloc と pool_free はロックを取らないので、1 つのスレッドからだけ使います。
+    pthread_mutex_t lock;
+} pool;
+
+void pool_init(pool* p, size_t object_size, int objects_per_slab) {
+    // 空いている間はオブジェクトの先頭にポインタを書き込むので、
+    // それが入る大きさとアラインメントに切り上げます。
+    size_t align = sizeof(free_object);
+    if (object_size < sizeof(free_object)) {
+        object_size = sizeof(free_object);
+    }
+    p->object_size = (object_size + align - 1) / align * align;
+    p->objects_per_slab = objects_per_slab;
+    p->slabs = NULL;
+    p->free_list = NULL;
+    p->num_slabs = 0;
+    pthread_mutex_init(&p->lock, NULL);
+}
+
+void pool_destroy(pool* p) {
+    slab* current = p->slabs;
+    while (current != NULL) {
+        slab* next = current->next;
+        free(current);
+        current = next;
+    }
+    p->slabs = NULL;
+    p->free_list = NULL;
+    p->num_slabs = 0;
+    pthread_mutex_destroy(&p->lock);
+}
+
+// 新しいスラブを確保して、すべてのオブジェクトを空きリストに追加します。
+// 先頭のオブジェクトから順に確保されるように、後ろから追加します。
+void pool_grow(pool* p) {
+    size_t size = SLAB_HEADER_SIZE + p->object_size * p->objects_per_slab;
+    slab* s = (slab*)aligned_alloc(64, (size + 63) / 64 * 64);
+    assert(s != NULL);
+    s->next = p->slabs;
+    p->slabs = s;
+    p->num_slabs++;
+
+    char* objects = (char*)s + SLAB_HEADER_SIZE;
+    for (int i = p->objects_per_slab - 1; i >= 0; i--) {
+        free_object* o = (free_object*)(objects + p->object_size * i);
+        o->next = p->free_list;
+        p->free_list = o;
+    }
+}
+
+void* pool_alloc(pool* p) {
+    if (p->free_list == NULL) {
+        pool_grow(p);
+    }
+    free_object* o = p->free_list;
+    p->free_list = o->next;
+    return o;
+}
+
+void pool_free(pool* p, void* object) {
+    free_object* o = (free_object*)object;
+    o->next = p->free_list;
+    p->free_list = o;
+}
+
+// スレッドごとのキャッシュです。
+// 複数のスレッドで 1 つのプールを共有すると、確保・解放のたびにロックが必要です。
+// そこで各スレッドが小さな空きリストを持ち、普段はそこから確保・解放して、
+// 空になったときと溜まりすぎたときだけ CACHE_BATCH 個ずつロックを取って
+// 共有のプールとやり取りします。
+typedef struct {
+    free_object* head;
+    int count;
+} pool_cache;
+
+void* cache_alloc(pool* p, pool_cache* cache) {
+    if (cache->head == NULL) {
+        pthread_mutex_lock(&p->lock);
+        for (int i = 0; i < CACHE_BATCH; i++) {
+            free_object* o = (free_object*)pool_alloc(p);
+            o->next = cache->head;
+            cache->head = o;
+        }
+        pthread_mutex_unlock(&p->lock);
+        cache->count = CACHE_BATCH;
+    }
+    free_object* o = cache->head;
+    cache->head = o->next;
+    cache->count--;
+    return o;
+}
+
+void cache_free(pool* p, pool_cache* cache, void* object) {
+    free_object* o = (free_object*)object;
+    o->next = cache->head;
+    cache->head = o;
+    cache->count++;
+    if (cache->count > 2 * CACHE_BATCH) {
+        pthread_mutex_lock(&p->lock);
+        for (int i = 0; i < CACHE_BATCH; i++) {
+            free_object* returned = cache->head;
+            cache->head = returned->next;
+            pool_free(p, returned);
+        }
+        pthread_mutex_unlock(&p->lock);
+        cache->count -= CACHE_BATCH;
+    }
+}
+
+// スレッドが終了する前に、キャッシュに残っているオブジェクトをプールに返します。
+void cache_flush(pool* p, pool_cache* cache) {
+    pthread_mutex_lock(&p->lock);
+    while (cache->head != NULL) {
+        free_object* returned = cache->head;
+        cache->head = returned->next;
+        pool_free(p, returned);
+    }
+    pthread_mutex_unlock(&p->lock);
+    cache->count = 0;
+}
+
+#endif
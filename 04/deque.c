@@ -0,0 +1,499 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 1 つの chunk に入る要素数です。
+#define CHUNK_SIZE 1024
+// 解放せずに取っておく空の chunk の最大数です。
+#define MAX_SPARE 4
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_OPERATIONS 10000000
+#define WINDOW 1000
+
+// 両端で追加と削除ができる、要素数に上限の無い deque です。
+// stack_array.c や queue_array.c のように 1 つの配列に入れるのではなく、
+// 固定長の配列 (chunk) をいくつも確保し、その先頭アドレスを map という配列に並べます。
+//
+//   map:    [ -  - c0 c1 c2  -  - ]   (first = 2, num_chunks = 3)
+//   c0:     [ -  -  -  a  b ]         (head = 3)
+//   c1:     [ c  d  e  f  g ]
+//   c2:     [ h  i  -  -  - ]         (length = 9)
+//
+// 要素が増えても新しい chunk を足すだけなので、既にある要素をコピーすることはありません。
+// map が足りなくなったときは map だけを作り直しますが、コピーするのは
+// chunk のアドレスだけで、その数は要素数の 1 / CHUNK_SIZE です。
+// 空になった chunk は MAX_SPARE 個まで spare に取っておき、次に chunk が必要になったときに使います。
+// chunk の境目で push と pop を繰り返しても、malloc と free を繰り返さずにすみます。
+typedef struct {
+    int** map;
+    int map_capacity;
+    // 使用中の chunk は map[first] から map[first + num_chunks - 1] です。
+    int first;
+    int num_chunks;
+    // 先頭の要素の map[first] の中での位置です。
+    int head;
+    int length;
+    int* spare[MAX_SPARE];
+    int num_spare;
+} deque;
+
+static int* new_chunk(deque* d) {
+    if (d->num_spare > 0) {
+        d->num_spare--;
+        return d->spare[d->num_spare];
+    }
+    return (int*)malloc(CHUNK_SIZE * sizeof(int));
+}
+
+static void delete_chunk(deque* d, int* chunk) {
+    if (d->num_spare < MAX_SPARE) {
+        d->spare[d->num_spare] = chunk;
+        d->num_spare++;
+    } else {
+        free(chunk);
+    }
+}
+
+// map の両端に 1 つ以上の空きができるように、使用中の chunk を map の中央に移します。
+// 空きが半分未満のときは map の大きさを 2 倍にします。
+static void recenter(deque* d) {
+    int capacity = d->map_capacity;
+    if (d->num_chunks >= capacity / 2) {
+        capacity = capacity == 0 ? 8 : capacity * 2;
+    }
+    int first = (capacity - d->num_chunks) / 2;
+    if (capacity == d->map_capacity) {
+        memmove(d->map + first, d->map + d->first, d->num_chunks * sizeof(int*));
+    } else {
+        int** map = (int**)malloc(capacity * sizeof(int*));
+        if (d->num_chunks > 0) {
+            memcpy(map + first, d->map + d->first, d->num_chunks * sizeof(int*));
+        }
+        free(d->map);
+        d->map = map;
+        d->map_capacity = capacity;
+    }
+    d->first = first;
+}
+
+void init(deque* d) {
+    d->map = NULL;
+    d->map_capacity = 0;
+    d->first = 0;
+    d->num_chunks = 0;
+    d->head = 0;
+    d->length = 0;
+    d->num_spare = 0;
+}
+
+// すべての chunk と map を解放します。clear の後は再び init からやり直さずに使えます。
+void clear(deque* d) {
+    for (int i = 0; i < d->num_chunks; i++) {
+        free(d->map[d->first + i]);
+    }
+    for (int i = 0; i < d->num_spare; i++) {
+        free(d->spare[i]);
+    }
+    free(d->map);
+    init(d);
+}
+
+bool empty(deque* d) {
+    return d->length == 0;
+}
+
+// 先頭から index 番目の要素のアドレスを返します。
+static inline int* at(deque* d, int index) {
+    unsigned position = (unsigned)(d->head + index);
+    return &d->map[d->first + position / CHUNK_SIZE][position % CHUNK_SIZE];
+}
+
+int get(deque* d, int index) {
+    assert(0 <= index && index < d->length);
+    return *at(d, index);
+}
+
+void push_back(deque* d, int val) {
+    if (d->head + d->length == d->num_chunks * CHUNK_SIZE) {
+        if (d->first + d->num_chunks == d->map_capacity) {
+            recenter(d);
+        }
+        d->map[d->first + d->num_chunks] = new_chunk(d);
+        d->num_chunks++;
+    }
+    *at(d, d->length) = val;
+    d->length++;
+}
+
+void push_front(deque* d, int val) {
+    if (d->head == 0) {
+        if (d->first == 0) {
+            recenter(d);
+        }
+        d->first--;
+        d->map[d->first] = new_chunk(d);
+        d->num_chunks++;
+        d->head = CHUNK_SIZE;
+    }
+    d->head--;
+    d->length++;
+    *at(d, 0) = val;
+}
+
+int pop_back(deque* d) {
+    assert(d->length > 0);
+
+    d->length--;
+    int val = *at(d, d->length);
+    // 最後の chunk が空になったら取り外します。
+    if (d->num_chunks * CHUNK_SIZE - (d->head + d->length) == CHUNK_SIZE) {
+        d->num_chunks--;
+        delete_chunk(d, d->map[d->first + d->num_chunks]);
+    }
+    return val;
+}
+
+int pop_front(deque* d) {
+    assert(d->length > 0);
+
+    int val = *at(d, 0);
+    d->head++;
+    d->length--;
+    // 最初の chunk が空になったら取り外します。
+    if (d->head == CHUNK_SIZE) {
+        delete_chunk(d, d->map[d->first]);
+        d->first++;
+        d->num_chunks--;
+        d->head = 0;
+    }
+    return val;
+}
+
+// stack_array.c の push と pop に相当します。
+void push(deque* d, int val) {
+    push_back(d, val);
+}
+
+int pop(deque* d) {
+    return pop_back(d);
+}
+
+// queue_array.c の enqueue と dequeue に相当します。
+void enqueue(deque* d, int val) {
+    push_back(d, val);
+}
+
+int dequeue(deque* d) {
+    return pop_front(d);
+}
+
+void print(deque* d) {
+    printf("DEQUE: [ ");
+    for (int i = 0; i < d->length; i++) {
+        printf("%d ", get(d, i));
+    }
+    printf("]\n");
+}
+
+// 比較用の、stack_array.c と queue_array.c をそのまま持ってきたものです。
+// 計測で溢れないよう、SIZE を NUM_OPERATIONS にしています。
+typedef struct {
+    int length;
+    int elements[NUM_OPERATIONS];
+} fixed_stack;
+
+void fixed_push(fixed_stack* stack, int val) {
+    assert(stack->length < NUM_OPERATIONS);
+
+    stack->elements[stack->length] = val;
+    stack->length++;
+}
+
+int fixed_pop(fixed_stack* stack) {
+    assert(stack->length != 0);
+
+    stack->length--;
+    return stack->elements[stack->length];
+}
+
+typedef struct {
+    int head;
+    int tail;
+    int count;
+    int elements[NUM_OPERATIONS];
+} fixed_queue;
+
+void fixed_enqueue(fixed_queue* q, int val) {
+    assert(q->count < NUM_OPERATIONS);
+
+    q->elements[q->tail] = val;
+    q->tail++;
+    if (q->tail >= NUM_OPERATIONS) {
+        q->tail = 0;
+    }
+    q->count++;
+}
+
+int fixed_dequeue(fixed_queue* q) {
+    assert(q->count > 0);
+
+    int val = q->elements[q->head];
+    q->head++;
+    if (q->head >= NUM_OPERATIONS) {
+        q->head = 0;
+    }
+    q->count--;
+    return val;
+}
+
+// 比較用の、stack_list.c と queue_list.c をそのまま持ってきたものです。
+typedef struct cell_ {
+    int element;
+    struct cell_* next;
+} cell;
+
+typedef struct {
+    cell* head;
+    cell* tail;
+} cell_list;
+
+void list_push(cell_list* s, int val) {
+    cell* c = (cell*)malloc(sizeof(cell));
+    c->element = val;
+    c->next = s->head;
+    s->head = c;
+}
+
+int list_pop(cell_list* s) {
+    assert(s->head != NULL);
+
+    int val = s->head->element;
+    cell* c = s->head;
+    s->head = s->head->next;
+    free(c);
+    return val;
+}
+
+void list_enqueue(cell_list* que, int val) {
+    cell* c = (cell*)malloc(sizeof(cell));
+    c->element = val;
+    c->next = NULL;
+
+    if (que->head == NULL) {
+        que->head = c;
+    } else {
+        que->tail->next = c;
+    }
+    que->tail = c;
+}
+
+int list_dequeue(cell_list* que) {
+    return list_pop(que);
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 3 つの使い方について、1 操作あたりの時間 (ns) を測ります。
+// stack:   NUM_OPERATIONS 回 push してから、すべて pop する
+// queue:   NUM_OPERATIONS 回 enqueue してから、すべて dequeue する
+// sliding: WINDOW 個の要素を入れたまま、enqueue と dequeue を NUM_OPERATIONS 回ずつ繰り返す
+typedef struct {
+    double stack;
+    double queue;
+    double sliding;
+    long long checksum;
+} result;
+
+void benchmark_fixed(result* r) {
+    fixed_stack* s = (fixed_stack*)malloc(sizeof(fixed_stack));
+    fixed_queue* q = (fixed_queue*)malloc(sizeof(fixed_queue));
+    long long sum = 0;
+
+    s->length = 0;
+    double start = now();
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        fixed_push(s, i);
+    }
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        sum += fixed_pop(s);
+    }
+    r->stack = (now() - start) * 1e9 / NUM_OPERATIONS / 2;
+
+    q->head = q->tail = q->count = 0;
+    start = now();
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        fixed_enqueue(q, i);
+    }
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        sum += fixed_dequeue(q);
+    }
+    r->queue = (now() - start) * 1e9 / NUM_OPERATIONS / 2;
+
+    start = now();
+    for (int i = 0; i < WINDOW; i++) {
+        fixed_enqueue(q, i);
+    }
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        fixed_enqueue(q, i);
+        sum += fixed_dequeue(q);
+    }
+    r->sliding = (now() - start) * 1e9 / NUM_OPERATIONS / 2;
+
+    r->checksum = sum;
+    free(s);
+    free(q);
+}
+
+void benchmark_list(result* r) {
+    cell_list s = {NULL, NULL};
+    cell_list q = {NULL, NULL};
+    long long sum = 0;
+
+    double start = now();
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        list_push(&s, i);
+    }
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        sum += list_pop(&s);
+    }
+    r->stack = (now() - start) * 1e9 / NUM_OPERATIONS / 2;
+
+    start = now();
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        list_enqueue(&q, i);
+    }
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        sum += list_dequeue(&q);
+    }
+    r->queue = (now() - start) * 1e9 / NUM_OPERATIONS / 2;
+
+    start = now();
+    for (int i = 0; i < WINDOW; i++) {
+        list_enqueue(&q, i);
+    }
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        list_enqueue(&q, i);
+        sum += list_dequeue(&q);
+    }
+    r->sliding = (now() - start) * 1e9 / NUM_OPERATIONS / 2;
+
+    r->checksum = sum;
+    while (q.head != NULL) {
+        list_dequeue(&q);
+    }
+}
+
+void benchmark_deque(result* r) {
+    deque d;
+    init(&d);
+    long long sum = 0;
+
+    double start = now();
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        push(&d, i);
+    }
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        sum += pop(&d);
+    }
+    r->stack = (now() - start) * 1e9 / NUM_OPERATIONS / 2;
+
+    start = now();
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        enqueue(&d, i);
+    }
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        sum += dequeue(&d);
+    }
+    r->queue = (now() - start) * 1e9 / NUM_OPERATIONS / 2;
+
+    start = now();
+    for (int i = 0; i < WINDOW; i++) {
+        enqueue(&d, i);
+    }
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        enqueue(&d, i);
+        sum += dequeue(&d);
+    }
+    r->sliding = (now() - start) * 1e9 / NUM_OPERATIONS / 2;
+
+    r->checksum = sum;
+    clear(&d);
+}
+
+int main() {
+    // stack_array.c と queue_array.c と同じ操作です。
+    deque d;
+    init(&d);
+    for (int i = 0; i < 10; i++) {
+        push(&d, i);
+    }
+    print(&d);
+    printf("POP: %d\n", pop(&d));
+    print(&d);
+
+    printf("DEQUEUE: %d\n", dequeue(&d));
+    print(&d);
+
+    push_front(&d, 100);
+    print(&d);
+
+    clear(&d);
+    print(&d);
+
+    // chunk の境目をまたいで両端から出し入れし、先頭からの順序が保たれていることを確かめます。
+    for (int i = 0; i < 5 * CHUNK_SIZE; i++) {
+        push_front(&d, -1 - i);
+        push_back(&d, i);
+    }
+    for (int i = 0; i < d.length; i++) {
+        assert(get(&d, i) == i - 5 * CHUNK_SIZE);
+    }
+    while (!empty(&d)) {
+        int front = pop_front(&d);
+        int back = pop_back(&d);
+        assert(front == -1 - back);
+    }
+    clear(&d);
+
+    printf("\nNUM_OPERATIONS = %d, CHUNK_SIZE = %d\n", NUM_OPERATIONS, CHUNK_SIZE);
+    printf("%-12s %10s %10s %10s   (ns / operation)\n", "", "stack", "queue", "sliding");
+    result fixed_result;
+    result list_result;
+    result deque_result;
+    benchmark_fixed(&fixed_result);
+    // linked list の後に計測すると、解放された大量の cell を malloc が整理する時間が
+    // deque の最初の chunk の確保に含まれてしまうので、先に計測します。
+    benchmark_deque(&deque_result);
+    benchmark_list(&list_result);
+    assert(fixed_result.checksum == list_result.checksum && list_result.checksum == deque_result.checksum);
+    printf("%-12s %10.2lf %10.2lf %10.2lf\n", "fixed array", fixed_result.stack, fixed_result.queue,
+           fixed_result.sliding);
+    printf("%-12s %10.2lf %10.2lf %10.2lf\n", "linked list", list_result.stack, list_result.queue,
+           list_result.sliding);
+    printf("%-12s %10.2lf %10.2lf %10.2lf\n", "deque", deque_result.stack, deque_result.queue,
+           deque_result.sliding);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// DEQUE: [ 0 1 2 3 4 5 6 7 8 9 ]
+// POP: 9
+// DEQUE: [ 0 1 2 3 4 5 6 7 8 ]
+// DEQUEUE: 0
+// DEQUE: [ 1 2 3 4 5 6 7 8 ]
+// DEQUE: [ 100 1 2 3 4 5 6 7 8 ]
+// DEQUE: [ ]
+//
+// NUM_OPERATIONS = 10000000, CHUNK_SIZE = 1024
+//                   stack      queue    sliding   (ns / operation)
+// fixed array        1.98       5.06       2.14
+// linked list       26.52      11.54       6.37
+// deque              4.99       4.11       3.47
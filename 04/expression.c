@@ -0,0 +1,496 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86_SIMD 1
+#else
+#define HAS_X86_SIMD 0
+#endif
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_ROWS (1 << 20)
+#define NUM_PASSES 10
+// 変数は 'a' から NUM_VARIABLES 個です。
+#define NUM_VARIABLES 8
+#define MAX_REGISTERS 32
+#define MAX_INSTRUCTIONS 256
+// 1 度に計算する行数です。使うレジスタの分だけ BATCH 個の double の配列を用意するので、
+// それらが L1 キャッシュに収まる程度にします。
+#define BATCH 256
+#define RANDOM_DEPTH 7
+
+// binary_tree.c の木は (a + b) * (c - d / e) という式を表しています。
+// 同じ式を変数の値だけ変えて何度も計算する場合、木を再帰的にたどると、
+// ノードごとに関数呼び出しと、演算子で分岐するためのほぼ予測できない分岐が必要です。
+// そこで、木を一度だけ帰りがけ順にたどって、命令の列 (program) に変換しておきます。
+//
+// 各命令は dst = left op right という形で、left と right には変数か
+// レジスタを指定します。帰りがけ順に命令を並べ、途中の結果をスタックに積んでいく
+// 代わりに、スタックの深さをそのままレジスタの番号にします。
+// こうするとスタックの操作が無くなり、命令は 4 バイトに収まります。
+//
+// さらに、変数の値を 1 行ずつではなく、変数ごとの配列 (列) として BATCH 行分まとめて渡し、
+// 1 つの命令を BATCH 行分まとめて実行します。命令の解釈や分岐は BATCH 行に 1 回だけになり、
+// 各命令の中身は単純な配列どうしの演算なので SIMD 命令で計算できます。
+typedef struct node_ {
+    char element;
+    struct node_* left;
+    struct node_* right;
+} node;
+
+node* init_node(char element) {
+    node* n = (node*)malloc(sizeof(node));
+    n->element = element;
+    n->left = NULL;
+    n->right = NULL;
+    return n;
+}
+
+// binary_tree.c の clear をそのまま持ってきたものです。
+void clear(node** p_current) {
+    node* current = *p_current;
+    if (current != NULL) {
+        clear(&current->left);
+        clear(&current->right);
+        free(current);
+        *p_current = NULL;
+    }
+}
+
+void in_order(node* p) {
+    if (p != NULL) {
+        if (p->left != NULL) {
+            printf("(");
+        }
+        in_order(p->left);
+        printf(p->left != NULL ? " %c " : "%c", p->element);
+        in_order(p->right);
+        if (p->left != NULL) {
+            printf(")");
+        }
+    }
+}
+
+// 比較用の、木を再帰的にたどって値を計算する関数です。
+// 変数 x の値は columns[x - 'a'][row] です。
+double evaluate(node* p, const double* const* columns, int row) {
+    switch (p->element) {
+    case '+':
+        return evaluate(p->left, columns, row) + evaluate(p->right, columns, row);
+    case '-':
+        return evaluate(p->left, columns, row) - evaluate(p->right, columns, row);
+    case '*':
+        return evaluate(p->left, columns, row) * evaluate(p->right, columns, row);
+    case '/':
+        return evaluate(p->left, columns, row) / evaluate(p->right, columns, row);
+    default:
+        return columns[p->element - 'a'][row];
+    }
+}
+
+typedef enum { ADD, SUBTRACT, MULTIPLY, DIVIDE } opcode;
+
+// 被演算子は 0 から NUM_VARIABLES - 1 が変数、REGISTER(i) がレジスタ i です。
+#define REGISTER(i) (NUM_VARIABLES + (i))
+
+typedef struct {
+    uint8_t op;
+    uint8_t dst;
+    uint8_t left;
+    uint8_t right;
+} instruction;
+
+typedef struct {
+    instruction code[MAX_INSTRUCTIONS];
+    int length;
+    int num_registers;
+    // 式全体の値が入る被演算子です。式が変数 1 つだけの場合は変数になります。
+    int result;
+} program;
+
+// p の値を計算する命令を追加し、その値が入る被演算子を返します。
+// depth 以上の番号のレジスタだけを使い、結果はレジスタ depth に入れます。
+// 左の部分木の結果をレジスタ depth に置いたまま、右の部分木は depth + 1 以上を使うので、
+// 必要なレジスタの数は木の深さ以下になります。
+static int compile_node(program* prog, node* p, int depth) {
+    if (p->left == NULL) {
+        assert('a' <= p->element && p->element < 'a' + NUM_VARIABLES);
+        return p->element - 'a';
+    }
+    int left = compile_node(prog, p->left, depth);
+    int right = compile_node(prog, p->right, left >= NUM_VARIABLES ? depth + 1 : depth);
+    assert(prog->length < MAX_INSTRUCTIONS && depth < MAX_REGISTERS);
+    instruction* inst = &prog->code[prog->length++];
+    switch (p->element) {
+    case '+':
+        inst->op = ADD;
+        break;
+    case '-':
+        inst->op = SUBTRACT;
+        break;
+    case '*':
+        inst->op = MULTIPLY;
+        break;
+    default:
+        assert(p->element == '/');
+        inst->op = DIVIDE;
+        break;
+    }
+    inst->dst = REGISTER(depth);
+    inst->left = left;
+    inst->right = right;
+    if (depth + 1 > prog->num_registers) {
+        prog->num_registers = depth + 1;
+    }
+    return inst->dst;
+}
+
+void compile(program* prog, node* root) {
+    prog->length = 0;
+    prog->num_registers = 0;
+    prog->result = compile_node(prog, root, 0);
+}
+
+void print_operand(int operand) {
+    if (operand < NUM_VARIABLES) {
+        printf("%c", 'a' + operand);
+    } else {
+        printf("r%d", operand - NUM_VARIABLES);
+    }
+}
+
+void print_program(const program* prog) {
+    const char operators[] = "+-*/";
+    for (int i = 0; i < prog->length; i++) {
+        const instruction* inst = &prog->code[i];
+        printf("  ");
+        print_operand(inst->dst);
+        printf(" = ");
+        print_operand(inst->left);
+        printf(" %c ", operators[inst->op]);
+        print_operand(inst->right);
+        printf("\n");
+    }
+}
+
+// program を 1 行分だけ実行します。
+double evaluate_program(const program* prog, const double* const* columns, int row) {
+    double values[NUM_VARIABLES + MAX_REGISTERS];
+    for (int v = 0; v < NUM_VARIABLES; v++) {
+        values[v] = columns[v][row];
+    }
+    for (int i = 0; i < prog->length; i++) {
+        const instruction* inst = &prog->code[i];
+        double left = values[inst->left];
+        double right = values[inst->right];
+        switch (inst->op) {
+        case ADD:
+            values[inst->dst] = left + right;
+            break;
+        case SUBTRACT:
+            values[inst->dst] = left - right;
+            break;
+        case MULTIPLY:
+            values[inst->dst] = left * right;
+            break;
+        default:
+            values[inst->dst] = left / right;
+            break;
+        }
+    }
+    return values[prog->result];
+}
+
+// dst[i] = left[i] op right[i] を length 個分計算します。dst は left や right と同じでも構いません。
+void apply(int op, double* dst, const double* left, const double* right, int length) {
+    switch (op) {
+    case ADD:
+        for (int i = 0; i < length; i++) {
+            dst[i] = left[i] + right[i];
+        }
+        break;
+    case SUBTRACT:
+        for (int i = 0; i < length; i++) {
+            dst[i] = left[i] - right[i];
+        }
+        break;
+    case MULTIPLY:
+        for (int i = 0; i < length; i++) {
+            dst[i] = left[i] * right[i];
+        }
+        break;
+    default:
+        for (int i = 0; i < length; i++) {
+            dst[i] = left[i] / right[i];
+        }
+        break;
+    }
+}
+
+#if HAS_X86_SIMD
+// SSE2 版です。1 命令で 2 個の double を計算します。
+// switch はループの外に出しておき、ループの中は読み込み・演算・書き込みだけにします。
+// 1 つの要素を読んでから書くまでに他の要素を書くことは無いので、dst が left や right と
+// 同じ配列でも正しく計算できます。
+__attribute__((target("sse2"))) void apply_sse2(int op, double* dst, const double* left, const double* right,
+                                                int length) {
+    int i = 0;
+    switch (op) {
+    case ADD:
+        for (; i + 2 <= length; i += 2) {
+            _mm_storeu_pd(dst + i, _mm_add_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+        }
+        break;
+    case SUBTRACT:
+        for (; i + 2 <= length; i += 2) {
+            _mm_storeu_pd(dst + i, _mm_sub_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+        }
+        break;
+    case MULTIPLY:
+        for (; i + 2 <= length; i += 2) {
+            _mm_storeu_pd(dst + i, _mm_mul_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+        }
+        break;
+    default:
+        for (; i + 2 <= length; i += 2) {
+            _mm_storeu_pd(dst + i, _mm_div_pd(_mm_loadu_pd(left + i), _mm_loadu_pd(right + i)));
+        }
+        break;
+    }
+    apply(op, dst + i, left + i, right + i, length - i);
+}
+
+// AVX2 版です。1 命令で 4 個の double を計算します。
+__attribute__((target("avx2"))) void apply_avx2(int op, double* dst, const double* left, const double* right,
+                                                int length) {
+    int i = 0;
+    switch (op) {
+    case ADD:
+        for (; i + 4 <= length; i += 4) {
+            _mm256_storeu_pd(dst + i, _mm256_add_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i)));
+        }
+        break;
+    case SUBTRACT:
+        for (; i + 4 <= length; i += 4) {
+            _mm256_storeu_pd(dst + i, _mm256_sub_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i)));
+        }
+        break;
+    case MULTIPLY:
+        for (; i + 4 <= length; i += 4) {
+            _mm256_storeu_pd(dst + i, _mm256_mul_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i)));
+        }
+        break;
+    default:
+        for (; i + 4 <= length; i += 4) {
+            _mm256_storeu_pd(dst + i, _mm256_div_pd(_mm256_loadu_pd(left + i), _mm256_loadu_pd(right + i)));
+        }
+        break;
+    }
+    apply(op, dst + i, left + i, right + i, length - i);
+}
+#endif
+
+// 実行時に CPUID で CPU が対応している命令を調べて、使う関数を選びます。
+void (*apply_simd)(int op, double* dst, const double* left, const double* right, int length) = apply;
+const char* apply_simd_name = "scalar";
+
+void init_apply_simd() {
+#if HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        apply_simd = apply_avx2;
+        apply_simd_name = "avx2";
+        return;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        apply_simd = apply_sse2;
+        apply_simd_name = "sse2";
+        return;
+    }
+#endif
+    apply_simd = apply;
+    apply_simd_name = "scalar";
+}
+
+typedef void (*apply_function)(int op, double* dst, const double* left, const double* right, int length);
+
+// program を length 行分実行し、結果を out に書き込みます。
+// BATCH 行ごとに、すべての命令をその BATCH 行に対して実行します。
+// 最後の命令は、レジスタではなく out に直接書き込みます。
+void evaluate_batch(const program* prog, const double* const* columns, int length, double* out,
+                    apply_function f) {
+    static _Alignas(64) double registers[MAX_REGISTERS][BATCH];
+    const double* operands[NUM_VARIABLES + MAX_REGISTERS];
+    for (int r = 0; r < MAX_REGISTERS; r++) {
+        operands[REGISTER(r)] = registers[r];
+    }
+    for (int start = 0; start < length; start += BATCH) {
+        int n = length - start < BATCH ? length - start : BATCH;
+        for (int v = 0; v < NUM_VARIABLES; v++) {
+            operands[v] = columns[v] + start;
+        }
+        if (prog->length == 0) {
+            memcpy(out + start, operands[prog->result], n * sizeof(double));
+            continue;
+        }
+        for (int i = 0; i < prog->length; i++) {
+            const instruction* inst = &prog->code[i];
+            double* dst = i == prog->length - 1 ? out + start : registers[inst->dst - NUM_VARIABLES];
+            f(inst->op, dst, operands[inst->left], operands[inst->right], n);
+        }
+    }
+}
+
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+// 深さが depth 以下の式の木をランダムに作ります。
+node* random_tree(int depth, uint64_t* state) {
+    if (depth == 0 || (depth < RANDOM_DEPTH && xorshift64(state) % 4 == 0)) {
+        return init_node((char)('a' + xorshift64(state) % NUM_VARIABLES));
+    }
+    node* n = init_node("+-*/"[xorshift64(state) % 4]);
+    n->left = random_tree(depth - 1, state);
+    n->right = random_tree(depth - 1, state);
+    return n;
+}
+
+int count_nodes(node* p) {
+    return p == NULL ? 0 : 1 + count_nodes(p->left) + count_nodes(p->right);
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 0 で割った結果どうしを計算すると NaN になることがあるので、NaN どうしも等しいとみなします。
+bool same(double a, double b) {
+    return a == b || (a != a && b != b);
+}
+
+// 1 行あたりの時間 (ns) を 4 つの方法で測り、結果が一致することを確認します。
+void benchmark(const char* name, node* root, const double* const* columns, double* expected, double* out) {
+    program prog;
+    compile(&prog, root);
+
+    double start = now();
+    for (int pass = 0; pass < NUM_PASSES; pass++) {
+        for (int row = 0; row < NUM_ROWS; row++) {
+            expected[row] = evaluate(root, columns, row);
+        }
+    }
+    double tree = (now() - start) * 1e9 / NUM_ROWS / NUM_PASSES;
+
+    start = now();
+    for (int pass = 0; pass < NUM_PASSES; pass++) {
+        for (int row = 0; row < NUM_ROWS; row++) {
+            out[row] = evaluate_program(&prog, columns, row);
+        }
+    }
+    double row = (now() - start) * 1e9 / NUM_ROWS / NUM_PASSES;
+    for (int i = 0; i < NUM_ROWS; i++) {
+        assert(same(out[i], expected[i]));
+    }
+
+    double batch[2];
+    apply_function functions[2] = {apply, apply_simd};
+    for (int f = 0; f < 2; f++) {
+        memset(out, 0, NUM_ROWS * sizeof(double));
+        start = now();
+        for (int pass = 0; pass < NUM_PASSES; pass++) {
+            evaluate_batch(&prog, columns, NUM_ROWS, out, functions[f]);
+        }
+        batch[f] = (now() - start) * 1e9 / NUM_ROWS / NUM_PASSES;
+        for (int i = 0; i < NUM_ROWS; i++) {
+            assert(same(out[i], expected[i]));
+        }
+    }
+
+    printf("%-8s %6d %10d %10.2lf %10.2lf %10.2lf %10.2lf\n", name, count_nodes(root), prog.num_registers, tree,
+           row, batch[0], batch[1]);
+}
+
+int main() {
+    init_apply_simd();
+
+    node* root = init_node('*');
+    root->left = init_node('+');
+    root->right = init_node('-');
+    root->left->left = init_node('a');
+    root->left->right = init_node('b');
+    root->right->left = init_node('c');
+    root->right->right = init_node('/');
+    root->right->right->left = init_node('d');
+    root->right->right->right = init_node('e');
+
+    program prog;
+    compile(&prog, root);
+    printf("TREE: ");
+    in_order(root);
+    printf("\nPROGRAM: (%d registers)\n", prog.num_registers);
+    print_program(&prog);
+
+    double* columns[NUM_VARIABLES];
+    uint64_t state = 88172645463325252ULL;
+    for (int v = 0; v < NUM_VARIABLES; v++) {
+        columns[v] = (double*)aligned_alloc(64, NUM_ROWS * sizeof(double));
+        for (int i = 0; i < NUM_ROWS; i++) {
+            // 1 以上 2 未満の値にします。
+            columns[v][i] = 1.0 + (double)(xorshift64(&state) >> 11) / (double)(1ULL << 53);
+        }
+    }
+    double* expected = (double*)malloc(NUM_ROWS * sizeof(double));
+    double* out = (double*)aligned_alloc(64, NUM_ROWS * sizeof(double));
+
+    printf("\nNUM_ROWS = %d, BATCH = %d, simd = %s\n", NUM_ROWS, BATCH, apply_simd_name);
+    printf("%-8s %6s %10s %10s %10s %10s %10s   (ns / row)\n", "tree", "nodes", "registers", "recursive",
+           "program", "batch", "batch simd");
+    benchmark("sample", root, (const double* const*)columns, expected, out);
+    clear(&root);
+
+    for (int i = 0; i < 3; i++) {
+        root = random_tree(RANDOM_DEPTH, &state);
+        char name[16];
+        snprintf(name, sizeof(name), "random%d", i);
+        benchmark(name, root, (const double* const*)columns, expected, out);
+        clear(&root);
+    }
+
+    for (int v = 0; v < NUM_VARIABLES; v++) {
+        free(columns[v]);
+    }
+    free(expected);
+    free(out);
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// TREE: ((a + b) * (c - (d / e)))
+// PROGRAM: (2 registers)
+//   r0 = a + b
+//   r1 = d / e
+//   r1 = c - r1
+//   r0 = r0 * r1
+//
+// NUM_ROWS = 1048576, BATCH = 256, simd = avx2
+// tree      nodes  registers  recursive    program      batch batch simd   (ns / row)
+// sample        9          2      37.76      20.55       7.40       6.03
+// random0      45          4     183.04      62.14      42.77      19.47
+// random1      59          4     312.71      81.04      43.00      20.29
+// random2      83          6     373.30     121.17      57.03      23.79
+// sample は計算が少なく、8 MB の列を 5 本読むメモリの転送速度で時間が決まるため、
+// batch simd の効果は小さくなります。
@@ -0,0 +1,331 @@
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_MESSAGES (1 << 22)
+#define CAPACITY 1024
+#define CACHE_LINE 64
+#define MAX_THREADS 8
+// 空き (またはデータ) が無いときに、この回数だけ再試行してから
+// sched_yield で CPU を他のスレッドに譲ります。
+#define SPIN 64
+
+// 複数の生産者と複数の消費者が同時に使える (multi-producer multi-consumer)、
+// 要素数に上限のある queue です。Dmitry Vyukov の方法によるもので、ロックを使いません。
+//
+// 配列の各要素 (slot) に sequence という番号を持たせます。
+// 添字 pos の slot は、sequence == pos ならば空いていて enqueue でき、
+// sequence == pos + 1 ならば値が入っていて dequeue できることを表します。
+// 1. enqueue は tail を読み、その slot が空いていれば CAS で tail を 1 進めて
+//    slot を確保します。CAS に成功したスレッドだけがその slot に書き込めます。
+//    値を書いてから sequence を pos + 1 にする (release) ことで、消費者に公開します。
+// 2. dequeue は head の slot の sequence が pos + 1 ならば CAS で head を進め、
+//    値を読んでから sequence を pos + capacity にして、1 周後の enqueue に渡します。
+// 生産者どうし・消費者どうしは CAS で競合しますが、生産者と消費者は
+// 別々の slot の sequence を見るだけなので、互いに待つことはほとんどありません。
+typedef struct {
+    atomic_size_t sequence;
+    int element;
+} slot;
+
+typedef struct {
+    slot* slots;
+    size_t mask;
+    _Alignas(CACHE_LINE) atomic_size_t tail;
+    _Alignas(CACHE_LINE) atomic_size_t head;
+} queue;
+
+// capacity は 2 のべき乗に切り上げます。
+void init(queue* q, size_t capacity) {
+    size_t power = 2;
+    while (power < capacity) {
+        power *= 2;
+    }
+    q->slots = (slot*)aligned_alloc(CACHE_LINE, power * sizeof(slot) < CACHE_LINE ? CACHE_LINE : power * sizeof(slot));
+    for (size_t i = 0; i < power; i++) {
+        atomic_init(&q->slots[i].sequence, i);
+    }
+    q->mask = power - 1;
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->head, 0);
+}
+
+// 他のスレッドが使っていないときに呼び出します。
+void destroy(queue* q) {
+    free(q->slots);
+    q->slots = NULL;
+}
+
+// 呼び出した時点で空だったかどうかを返します。
+// 他のスレッドが同時に enqueue や dequeue をしている場合、戻ってきたときには
+// 状態が変わっているかもしれません。
+bool empty(queue* q) {
+    return atomic_load(&q->head) == atomic_load(&q->tail);
+}
+
+// 満杯ならば false を返します。
+bool try_enqueue(queue* q, int val) {
+    size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    slot* s;
+    while (true) {
+        s = &q->slots[pos & q->mask];
+        size_t sequence = atomic_load_explicit(&s->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+        if (diff == 0) {
+            // 失敗した場合は pos が最新の tail に更新されます。
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // 1 周前の値がまだ dequeue されていません。
+            return false;
+        } else {
+            // 他の生産者が先にこの slot を確保しました。
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+    s->element = val;
+    atomic_store_explicit(&s->sequence, pos + 1, memory_order_release);
+    return true;
+}
+
+// 空ならば false を返します。
+bool try_dequeue(queue* q, int* val) {
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    slot* s;
+    while (true) {
+        s = &q->slots[pos & q->mask];
+        size_t sequence = atomic_load_explicit(&s->sequence, memory_order_acquire);
+        intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+        if (diff == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1, memory_order_relaxed,
+                                                      memory_order_relaxed)) {
+                break;
+            }
+        } else if (diff < 0) {
+            return false;
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+    *val = s->element;
+    atomic_store_explicit(&s->sequence, pos + q->mask + 1, memory_order_release);
+    return true;
+}
+
+// 失敗が続いたら CPU を譲ります。
+static inline void backoff(int* failures) {
+    if (++*failures >= SPIN) {
+        sched_yield();
+        *failures = 0;
+    }
+}
+
+// queue_array.c の enqueue と同じ形です。満杯の間は空くまで待ちます。
+void enqueue(queue* q, int val) {
+    int failures = 0;
+    while (!try_enqueue(q, val)) {
+        backoff(&failures);
+    }
+}
+
+// queue_array.c の dequeue と同じ形です。
+// 複数のスレッドがある場合は empty で確認してから dequeue しても
+// その間に他のスレッドに取られることがあるため、assert ではなく
+// 値が入るまで待ちます。
+int dequeue(queue* q) {
+    int failures = 0;
+    int val;
+    while (!try_dequeue(q, &val)) {
+        backoff(&failures);
+    }
+    return val;
+}
+
+void print(queue* q) {
+    printf("QUEUE: [ ");
+    size_t tail = atomic_load(&q->tail);
+    for (size_t i = atomic_load(&q->head); i != tail; i++) {
+        printf("%d ", q->slots[i & q->mask].element);
+    }
+    printf("]\n");
+}
+
+// 比較用の、queue_list.c の queue を mutex で保護したものです。
+typedef struct cell_ {
+    int element;
+    struct cell_* next;
+} cell;
+
+typedef struct {
+    cell* head;
+    cell* tail;
+    pthread_mutex_t lock;
+} locked_queue;
+
+void locked_enqueue(locked_queue* que, int val) {
+    cell* c = (cell*)malloc(sizeof(cell));
+    c->element = val;
+    c->next = NULL;
+
+    pthread_mutex_lock(&que->lock);
+    if (que->head == NULL) {
+        que->head = c;
+    } else {
+        que->tail->next = c;
+    }
+    que->tail = c;
+    pthread_mutex_unlock(&que->lock);
+}
+
+bool locked_try_dequeue(locked_queue* que, int* val) {
+    pthread_mutex_lock(&que->lock);
+    cell* c = que->head;
+    if (c != NULL) {
+        que->head = c->next;
+    }
+    pthread_mutex_unlock(&que->lock);
+    if (c == NULL) {
+        return false;
+    }
+    *val = c->element;
+    free(c);
+    return true;
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 生産者は NUM_MESSAGES / num_producers 個ずつ値を送り、
+// 消費者は NUM_MESSAGES / num_consumers 個ずつ値を受け取って合計を求めます。
+typedef struct {
+    bool locked;
+    queue* q;
+    locked_queue* lq;
+    int num_producers;
+    int num_consumers;
+    atomic_llong sum;
+} channel;
+
+typedef struct {
+    channel* ch;
+    int index;
+} worker;
+
+void* producer_main(void* arg) {
+    worker* w = (worker*)arg;
+    channel* ch = w->ch;
+    int count = NUM_MESSAGES / ch->num_producers;
+    for (int i = w->index * count; i < (w->index + 1) * count; i++) {
+        if (ch->locked) {
+            locked_enqueue(ch->lq, i);
+        } else {
+            enqueue(ch->q, i);
+        }
+    }
+    return NULL;
+}
+
+void* consumer_main(void* arg) {
+    worker* w = (worker*)arg;
+    channel* ch = w->ch;
+    long long sum = 0;
+    int failures = 0;
+    for (int i = 0; i < NUM_MESSAGES / ch->num_consumers; i++) {
+        if (ch->locked) {
+            int val;
+            while (!locked_try_dequeue(ch->lq, &val)) {
+                backoff(&failures);
+            }
+            sum += val;
+        } else {
+            sum += dequeue(ch->q);
+        }
+    }
+    atomic_fetch_add(&ch->sum, sum);
+    return NULL;
+}
+
+// 1 秒あたりのメッセージ数を返します。
+double throughput(bool locked, int num_producers, int num_consumers) {
+    queue q;
+    init(&q, CAPACITY);
+    locked_queue lq = {NULL, NULL, PTHREAD_MUTEX_INITIALIZER};
+    channel ch = {locked, &q, &lq, num_producers, num_consumers, 0};
+
+    pthread_t threads[2 * MAX_THREADS];
+    worker workers[2 * MAX_THREADS];
+    double start = now();
+    for (int i = 0; i < num_producers + num_consumers; i++) {
+        bool producer = i < num_producers;
+        workers[i].ch = &ch;
+        workers[i].index = producer ? i : i - num_producers;
+        pthread_create(&threads[i], NULL, producer ? producer_main : consumer_main, &workers[i]);
+    }
+    for (int i = 0; i < num_producers + num_consumers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now() - start;
+
+    assert(atomic_load(&ch.sum) == (long long)NUM_MESSAGES * (NUM_MESSAGES - 1) / 2);
+    assert(empty(&q) && lq.head == NULL);
+    destroy(&q);
+    return NUM_MESSAGES / elapsed;
+}
+
+int main() {
+    // queue_array.c と同じ操作を 1 つのスレッドで確認します。
+    queue q;
+    init(&q, 16);
+    for (int i = 0; i < 10; i++) {
+        enqueue(&q, i);
+    }
+    print(&q);
+
+    printf("DEQUEUE: %d\n", dequeue(&q));
+    print(&q);
+
+    while (!empty(&q)) {
+        dequeue(&q);
+    }
+    print(&q);
+    destroy(&q);
+
+    int configurations[][2] = {{1, 1}, {2, 2}, {4, 4}, {8, 8}, {1, 4}, {4, 1}};
+    printf("\n%9s %9s %16s %16s\n", "producers", "consumers", "locked list/s", "mpmc array/s");
+    for (int i = 0; i < 6; i++) {
+        int p = configurations[i][0];
+        int c = configurations[i][1];
+        printf("%9d %9d %16.0lf %16.0lf\n", p, c, throughput(true, p, c), throughput(false, p, c));
+    }
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// CPU が 1 コアの環境で実行したため、スレッドは同時には動いておらず、
+// mutex の競合もほとんど起きていません。複数コアの環境では結果が大きく変わります。
+// QUEUE: [ 0 1 2 3 4 5 6 7 8 9 ]
+// DEQUEUE: 0
+// QUEUE: [ 1 2 3 4 5 6 7 8 9 ]
+// QUEUE: [ ]
+//
+// producers consumers    locked list/s     mpmc array/s
+//         1         1         10805981         25781666
+//         2         2         10812479         24745853
+//         4         4         10101347         22933544
+//         8         8         10217146         20146588
+//         1         4         10748262         23555684
+//         4         1          9052218         23717938
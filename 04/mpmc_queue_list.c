@@ -0,0 +1,443 @@
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_MESSAGES (1 << 22)
+#define CACHE_LINE 64
+// hazard pointer を使えるスレッドの最大数です。
+#define MAX_THREADS 64
+// 1 つのスレッドが解放を保留している cell がこの数を超えたら、まとめて解放を試みます。
+#define RETIRE_THRESHOLD (4 * MAX_THREADS)
+// データが無いときに、この回数だけ再試行してから sched_yield で CPU を譲ります。
+#define SPIN 64
+
+// 複数の生産者と複数の消費者が同時に使える (multi-producer multi-consumer)、
+// 要素数に上限の無い queue です。Michael と Scott の方法によるもので、ロックを使いません。
+//
+// queue_list.c と同じく cell の連結リストですが、
+// 1. head は常に番兵 (dummy) の cell を指し、先頭の要素は head->next です。
+//    こうすると enqueue は tail だけを、dequeue は head だけを書き換えます。
+// 2. enqueue は tail->next が NULL のときに CAS で新しい cell をつなぎ、
+//    その後で tail を進めます。tail が遅れているのを見つけたスレッドは、
+//    代わりに tail を進めてから (helping) やり直します。
+// 3. dequeue は CAS で head を次の cell に進め、古い番兵を解放します。
+//
+// 問題は 3 の解放です。他のスレッドがまだ古い番兵を読んでいる途中かもしれないので、
+// すぐには free できません。ここでは hazard pointer を使います。
+// 各スレッドは cell を読む前に、その cell のアドレスを自分の hazard pointer に
+// 書いて公開します。取り外した cell は一旦 retired リストに入れておき、
+// どのスレッドの hazard pointer にも載っていないことを確かめてから free します。
+
+typedef struct cell_ {
+    int element;
+    _Atomic(struct cell_*) next;
+} cell;
+
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic(cell*) head;
+    _Alignas(CACHE_LINE) _Atomic(cell*) tail;
+} queue;
+
+// スレッドごとに 2 つの hazard pointer を持ちます。
+// 他のスレッドの hazard pointer と同じキャッシュラインにならないようにします。
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic(cell*) pointers[2];
+} hazard;
+
+hazard hazards[MAX_THREADS];
+atomic_int num_registered_threads = 0;
+
+// スレッドごとの状態です。最初に queue を使うときに番号を割り当てます。
+_Thread_local int thread_index = -1;
+_Thread_local cell* retired[2 * RETIRE_THRESHOLD];
+_Thread_local int num_retired = 0;
+
+// 終了したスレッドが解放しきれなかった cell です。clear で解放します。
+// これらの cell は止まっている enqueue がまだ読んでいて、tail->next への CAS が
+// 成功するかどうかを next == NULL で判定しているかもしれません。
+// そのため取り外した cell の next は書き換えず、別の配列に入れておきます。
+cell** orphans = NULL;
+int num_orphans = 0;
+int orphans_capacity = 0;
+pthread_mutex_t orphans_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static inline hazard* my_hazard() {
+    if (thread_index < 0) {
+        thread_index = atomic_fetch_add(&num_registered_threads, 1);
+        assert(thread_index < MAX_THREADS);
+    }
+    return &hazards[thread_index];
+}
+
+// *source を読み、その値を hazard pointer i に公開してから返します。
+// 公開する前に他のスレッドが解放しているかもしれないので、公開した後で
+// *source が変わっていないことを確かめます。
+static inline cell* protect(int i, _Atomic(cell*)* source) {
+    hazard* h = my_hazard();
+    cell* p = atomic_load(source);
+    while (true) {
+        atomic_store(&h->pointers[i], p);
+        cell* again = atomic_load(source);
+        if (again == p) {
+            return p;
+        }
+        p = again;
+    }
+}
+
+static inline void release(int i) {
+    atomic_store_explicit(&my_hazard()->pointers[i], NULL, memory_order_release);
+}
+
+// retired リストのうち、どの hazard pointer にも載っていない cell を解放します。
+void scan() {
+    int num_threads = atomic_load(&num_registered_threads);
+    int kept = 0;
+    for (int r = 0; r < num_retired; r++) {
+        bool in_use = false;
+        for (int t = 0; t < num_threads && !in_use; t++) {
+            in_use = atomic_load(&hazards[t].pointers[0]) == retired[r] ||
+                     atomic_load(&hazards[t].pointers[1]) == retired[r];
+        }
+        if (in_use) {
+            retired[kept++] = retired[r];
+        } else {
+            free(retired[r]);
+        }
+    }
+    num_retired = kept;
+}
+
+void retire(cell* c) {
+    retired[num_retired++] = c;
+    if (num_retired >= RETIRE_THRESHOLD) {
+        scan();
+    }
+}
+
+// スレッドが終了する前に呼び出します。
+void thread_exit() {
+    scan();
+    pthread_mutex_lock(&orphans_lock);
+    if (num_orphans + num_retired > orphans_capacity) {
+        orphans_capacity = orphans_capacity > 0 ? orphans_capacity : RETIRE_THRESHOLD;
+        while (num_orphans + num_retired > orphans_capacity) {
+            orphans_capacity *= 2;
+        }
+        orphans = (cell**)realloc(orphans, orphans_capacity * sizeof(cell*));
+    }
+    memcpy(orphans + num_orphans, retired, num_retired * sizeof(cell*));
+    num_orphans += num_retired;
+    pthread_mutex_unlock(&orphans_lock);
+    num_retired = 0;
+}
+
+void init(queue* q) {
+    cell* dummy = (cell*)malloc(sizeof(cell));
+    atomic_init(&dummy->next, NULL);
+    atomic_init(&q->head, dummy);
+    atomic_init(&q->tail, dummy);
+}
+
+// queue_list.c の clear に相当します。他のスレッドが使っていないときに呼び出します。
+// 番兵の cell も解放するので、再び使う場合は init からやり直します。
+void clear(queue* q) {
+    cell* current = atomic_load(&q->head);
+    while (current != NULL) {
+        cell* next = atomic_load_explicit(&current->next, memory_order_relaxed);
+        free(current);
+        current = next;
+    }
+    atomic_store(&q->head, NULL);
+    atomic_store(&q->tail, NULL);
+
+    scan();
+    pthread_mutex_lock(&orphans_lock);
+    for (int i = 0; i < num_orphans; i++) {
+        free(orphans[i]);
+    }
+    free(orphans);
+    orphans = NULL;
+    num_orphans = 0;
+    orphans_capacity = 0;
+    pthread_mutex_unlock(&orphans_lock);
+}
+
+// 呼び出した時点で空だったかどうかを返します。
+bool empty(queue* q) {
+    cell* head = protect(0, &q->head);
+    bool result = atomic_load(&head->next) == NULL;
+    release(0);
+    return result;
+}
+
+void enqueue(queue* q, int val) {
+    cell* c = (cell*)malloc(sizeof(cell));
+    c->element = val;
+    atomic_init(&c->next, NULL);
+
+    while (true) {
+        cell* tail = protect(0, &q->tail);
+        cell* next = atomic_load(&tail->next);
+        if (next == NULL) {
+            cell* expected = NULL;
+            if (atomic_compare_exchange_weak(&tail->next, &expected, c)) {
+                // tail を進めるのに失敗しても、他のスレッドが進めてくれます。
+                atomic_compare_exchange_strong(&q->tail, &tail, c);
+                break;
+            }
+        } else {
+            // tail が遅れているので、進めてからやり直します。
+            atomic_compare_exchange_strong(&q->tail, &tail, next);
+        }
+    }
+    release(0);
+}
+
+// 空ならば false を返します。
+bool try_dequeue(queue* q, int* val) {
+    while (true) {
+        cell* head = protect(0, &q->head);
+        cell* next = protect(1, &head->next);
+        // head を公開してから next を読むまでの間に、head が取り外されて
+        // いないことを確かめます (取り外されていれば next は古い値かもしれません)。
+        if (atomic_load(&q->head) != head) {
+            continue;
+        }
+        if (next == NULL) {
+            release(0);
+            release(1);
+            return false;
+        }
+        // 要素を追加した直後で tail がまだ進んでいない場合は、先に進めます。
+        cell* tail = atomic_load(&q->tail);
+        if (head == tail) {
+            atomic_compare_exchange_strong(&q->tail, &tail, next);
+            continue;
+        }
+        int element = next->element;
+        if (atomic_compare_exchange_strong(&q->head, &head, next)) {
+            release(0);
+            release(1);
+            *val = element;
+            // 古い番兵を解放します。next が新しい番兵になります。
+            retire(head);
+            return true;
+        }
+    }
+}
+
+// 失敗が続いたら CPU を譲ります。
+static inline void backoff(int* failures) {
+    if (++*failures >= SPIN) {
+        sched_yield();
+        *failures = 0;
+    }
+}
+
+// queue_list.c の dequeue と同じ形です。
+// 複数のスレッドがある場合は empty で確認してから dequeue しても
+// その間に他のスレッドに取られることがあるため、assert ではなく
+// 値が入るまで待ちます。
+int dequeue(queue* q) {
+    int failures = 0;
+    int val;
+    while (!try_dequeue(q, &val)) {
+        backoff(&failures);
+    }
+    return val;
+}
+
+void print(queue* q) {
+    printf("QUEUE: [ ");
+    cell* current = atomic_load(&atomic_load(&q->head)->next);
+    while (current != NULL) {
+        printf("%d ", current->element);
+        current = atomic_load(&current->next);
+    }
+    printf("]\n");
+}
+
+// 比較用の、queue_list.c の queue を mutex で保護したものです。
+typedef struct plain_cell_ {
+    int element;
+    struct plain_cell_* next;
+} plain_cell;
+
+typedef struct {
+    plain_cell* head;
+    plain_cell* tail;
+    pthread_mutex_t lock;
+} locked_queue;
+
+void locked_enqueue(locked_queue* que, int val) {
+    plain_cell* c = (plain_cell*)malloc(sizeof(plain_cell));
+    c->element = val;
+    c->next = NULL;
+
+    pthread_mutex_lock(&que->lock);
+    if (que->head == NULL) {
+        que->head = c;
+    } else {
+        que->tail->next = c;
+    }
+    que->tail = c;
+    pthread_mutex_unlock(&que->lock);
+}
+
+bool locked_try_dequeue(locked_queue* que, int* val) {
+    pthread_mutex_lock(&que->lock);
+    plain_cell* c = que->head;
+    if (c != NULL) {
+        que->head = c->next;
+    }
+    pthread_mutex_unlock(&que->lock);
+    if (c == NULL) {
+        return false;
+    }
+    *val = c->element;
+    free(c);
+    return true;
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 生産者は NUM_MESSAGES / num_producers 個ずつ値を送り、
+// 消費者は NUM_MESSAGES / num_consumers 個ずつ値を受け取って合計を求めます。
+typedef struct {
+    bool locked;
+    queue* q;
+    locked_queue* lq;
+    int num_producers;
+    int num_consumers;
+    atomic_llong sum;
+} channel;
+
+typedef struct {
+    channel* ch;
+    int index;
+} worker;
+
+void* producer_main(void* arg) {
+    worker* w = (worker*)arg;
+    channel* ch = w->ch;
+    int count = NUM_MESSAGES / ch->num_producers;
+    for (int i = w->index * count; i < (w->index + 1) * count; i++) {
+        if (ch->locked) {
+            locked_enqueue(ch->lq, i);
+        } else {
+            enqueue(ch->q, i);
+        }
+    }
+    thread_exit();
+    return NULL;
+}
+
+void* consumer_main(void* arg) {
+    worker* w = (worker*)arg;
+    channel* ch = w->ch;
+    long long sum = 0;
+    int failures = 0;
+    for (int i = 0; i < NUM_MESSAGES / ch->num_consumers; i++) {
+        if (ch->locked) {
+            int val;
+            while (!locked_try_dequeue(ch->lq, &val)) {
+                backoff(&failures);
+            }
+            sum += val;
+        } else {
+            sum += dequeue(ch->q);
+        }
+    }
+    atomic_fetch_add(&ch->sum, sum);
+    thread_exit();
+    return NULL;
+}
+
+// 1 秒あたりのメッセージ数を返します。
+// hazard pointer の番号はスレッドを作るたびに割り当てるので、
+// 計測のたびに作り直せるように番号を 0 に戻します (他のスレッドがいないときだけ安全です)。
+double throughput(bool locked, int num_producers, int num_consumers) {
+    queue q;
+    init(&q);
+    locked_queue lq = {NULL, NULL, PTHREAD_MUTEX_INITIALIZER};
+    channel ch = {locked, &q, &lq, num_producers, num_consumers, 0};
+    atomic_store(&num_registered_threads, 0);
+    thread_index = -1;
+
+    pthread_t threads[MAX_THREADS];
+    worker workers[MAX_THREADS];
+    double start = now();
+    for (int i = 0; i < num_producers + num_consumers; i++) {
+        bool producer = i < num_producers;
+        workers[i].ch = &ch;
+        workers[i].index = producer ? i : i - num_producers;
+        pthread_create(&threads[i], NULL, producer ? producer_main : consumer_main, &workers[i]);
+    }
+    for (int i = 0; i < num_producers + num_consumers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now() - start;
+
+    assert(atomic_load(&ch.sum) == (long long)NUM_MESSAGES * (NUM_MESSAGES - 1) / 2);
+    assert(empty(&q) && lq.head == NULL);
+    clear(&q);
+    return NUM_MESSAGES / elapsed;
+}
+
+int main() {
+    // queue_list.c と同じ操作を 1 つのスレッドで確認します。
+    queue q;
+    init(&q);
+    for (int i = 0; i < 10; i++) {
+        enqueue(&q, i);
+    }
+    print(&q);
+
+    printf("DEQUEUE: %d\n", dequeue(&q));
+    print(&q);
+
+    while (!empty(&q)) {
+        dequeue(&q);
+    }
+    print(&q);
+    clear(&q);
+
+    int configurations[][2] = {{1, 1}, {2, 2}, {4, 4}, {8, 8}, {1, 4}, {4, 1}};
+    printf("\n%9s %9s %16s %16s\n", "producers", "consumers", "locked list/s", "mpmc list/s");
+    for (int i = 0; i < 6; i++) {
+        int p = configurations[i][0];
+        int c = configurations[i][1];
+        printf("%9d %9d %16.0lf %16.0lf\n", p, c, throughput(true, p, c), throughput(false, p, c));
+    }
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// CPU が 1 コアの環境で実行したため、スレッドは同時には動いておらず、
+// mutex の競合もほとんど起きていません。複数コアの環境では結果が大きく変わります。
+// QUEUE: [ 0 1 2 3 4 5 6 7 8 9 ]
+// DEQUEUE: 0
+// QUEUE: [ 1 2 3 4 5 6 7 8 9 ]
+// QUEUE: [ ]
+//
+// producers consumers    locked list/s      mpmc list/s
+//         1         1         11453968          9143290
+//         2         2         10641254          8792568
+//         4         4          9398860          7391066
+//         8         8          7684457          6580940
+//         1         4         10677395          8402594
+//         4         1          9382296          7724485
@@ -4,11 +4,24 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../03/pool_allocator.h"
+
 typedef struct cell_ {
     int element;
     struct cell_* next;
 } cell;
 
+// cell は malloc ではなく 03/pool_allocator.h のプールから確保します。
+pool cell_pool;
+
+cell* new_cell() {
+    return (cell*)pool_alloc(&cell_pool);
+}
+
+void delete_cell(cell* c) {
+    pool_free(&cell_pool, c);
+}
+
 typedef struct {
     cell* head;
     cell* tail;
@@ -18,7 +31,7 @@ void clear(queue* que) {
     cell* current = que->head;
     while (current != NULL) {
         cell* next = current->next;
-        free(current);
+        delete_cell(current);
         current = next;
     }
     que->head = NULL;
@@ -30,7 +43,7 @@ bool empty(queue* que) {
 }
 
 void enqueue(queue* que, int val) {
-    cell* c = (cell*)malloc(sizeof(cell));
+    cell* c = new_cell();
     c->element = val;
     c->next = NULL;
 
@@ -49,7 +62,7 @@ int dequeue(queue* que) {
     int val = que->head->element;
     cell* c = que->head;
     que->head = que->head->next;
-    free(c);
+    delete_cell(c);
     return val;
 }
 
@@ -64,6 +77,7 @@ void print(queue* q) {
 }
 
 int main() {
+    pool_init(&cell_pool, sizeof(cell), OBJECTS_PER_SLAB);
     queue q = {NULL, NULL};
 
     for (int i = 0; i < 10; i++) {
@@ -76,6 +90,7 @@ int main() {
 
     clear(&q);
     print(&q);
+    pool_destroy(&cell_pool);
     return 0;
 }
 
@@ -0,0 +1,413 @@
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_MESSAGES 10000000
+#define NUM_PINGS 100000
+#define CAPACITY 1024
+#define BATCH 64
+#define CACHE_LINE 64
+// 空き (またはデータ) が無いときに、この回数だけ再試行してから
+// sched_yield で CPU を相手のスレッドに譲ります。
+#define SPIN 64
+
+// queue_array.c の queue は 1 つのスレッドから使うことしか考えていないため、
+// 生産者 (enqueue するスレッド) と消費者 (dequeue するスレッド) が同時に
+// count を書き換えると値が壊れます。
+// この queue は生産者と消費者がそれぞれ 1 つずつ (single-producer single-consumer)
+// の場合に限って、ロックを使わずに安全に使えるリングバッファです。
+// 1. tail は生産者だけが、head は消費者だけが書き換えます。count は持たず、
+//    要素数は tail - head で求めます。
+// 2. head と tail は 0 から増え続ける添字で、配列の位置は
+//    添字 & (capacity - 1) です。capacity を 2 のべき乗にすると、
+//    queue_array.c のような折り返しの分岐も剰余の計算も要りません。
+// 3. 生産者は要素を書き込んでから tail を release で書き込み、消費者は
+//    tail を acquire で読んでから要素を読みます。これで消費者は tail が
+//    進んだのを見た時点で、要素の書き込みも見えることが保証されます (head も同様)。
+// 4. head と tail を同じキャッシュラインに置くと、片方を書き換えるたびに
+//    もう片方のスレッドのキャッシュからそのラインが追い出されます (false sharing)。
+//    そこで別々のキャッシュラインに置きます。
+// 5. 生産者は相手の head を毎回読むのではなく、前回読んだ値 (cached_head) を
+//    覚えておき、それでは満杯に見えるときだけ読み直します。消費者も同様です。
+typedef struct {
+    int* elements;
+    size_t capacity;
+    size_t mask;
+    // 生産者が使うキャッシュラインです。
+    _Alignas(CACHE_LINE) atomic_size_t tail;
+    size_t cached_head;
+    // 消費者が使うキャッシュラインです。
+    _Alignas(CACHE_LINE) atomic_size_t head;
+    size_t cached_tail;
+} spsc_queue;
+
+void init(spsc_queue* q, size_t capacity) {
+    size_t power = 1;
+    while (power < capacity) {
+        power *= 2;
+    }
+    q->elements = (int*)aligned_alloc(CACHE_LINE, power * sizeof(int) < CACHE_LINE ? CACHE_LINE : power * sizeof(int));
+    q->capacity = power;
+    q->mask = power - 1;
+    atomic_init(&q->tail, 0);
+    atomic_init(&q->head, 0);
+    q->cached_head = 0;
+    q->cached_tail = 0;
+}
+
+void destroy(spsc_queue* q) {
+    free(q->elements);
+    q->elements = NULL;
+}
+
+// 生産者から呼び出します。満杯ならば false を返します。
+bool enqueue(spsc_queue* q, int val) {
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    if (tail - q->cached_head == q->capacity) {
+        q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+        if (tail - q->cached_head == q->capacity) {
+            return false;
+        }
+    }
+    q->elements[tail & q->mask] = val;
+    atomic_store_explicit(&q->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+// 消費者から呼び出します。空ならば false を返します。
+bool dequeue(spsc_queue* q, int* val) {
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    if (head == q->cached_tail) {
+        q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        if (head == q->cached_tail) {
+            return false;
+        }
+    }
+    *val = q->elements[head & q->mask];
+    atomic_store_explicit(&q->head, head + 1, memory_order_release);
+    return true;
+}
+
+// values[0 .. n) のうち入るだけを enqueue し、その数を返します。
+// tail の書き込みはまとめて 1 回だけなので、相手のキャッシュを乱す回数も減ります。
+size_t enqueue_n(spsc_queue* q, const int* values, size_t n) {
+    size_t tail = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    size_t space = q->capacity - (tail - q->cached_head);
+    if (space < n) {
+        q->cached_head = atomic_load_explicit(&q->head, memory_order_acquire);
+        space = q->capacity - (tail - q->cached_head);
+    }
+    n = n < space ? n : space;
+    // 配列の末尾で折り返す場合は 2 回に分けてコピーします。
+    size_t start = tail & q->mask;
+    size_t first = q->capacity - start < n ? q->capacity - start : n;
+    memcpy(q->elements + start, values, first * sizeof(int));
+    memcpy(q->elements, values + first, (n - first) * sizeof(int));
+    atomic_store_explicit(&q->tail, tail + n, memory_order_release);
+    return n;
+}
+
+// 最大 n 個を values に dequeue し、その数を返します。
+size_t dequeue_n(spsc_queue* q, int* values, size_t n) {
+    size_t head = atomic_load_explicit(&q->head, memory_order_relaxed);
+    size_t available = q->cached_tail - head;
+    if (available < n) {
+        q->cached_tail = atomic_load_explicit(&q->tail, memory_order_acquire);
+        available = q->cached_tail - head;
+    }
+    n = n < available ? n : available;
+    size_t start = head & q->mask;
+    size_t first = q->capacity - start < n ? q->capacity - start : n;
+    memcpy(values, q->elements + start, first * sizeof(int));
+    memcpy(values + first, q->elements, (n - first) * sizeof(int));
+    atomic_store_explicit(&q->head, head + n, memory_order_release);
+    return n;
+}
+
+// 生産者・消費者のどちらからでも呼び出せますが、結果は呼び出した時点の目安です。
+bool empty(spsc_queue* q) {
+    return atomic_load_explicit(&q->head, memory_order_acquire) ==
+           atomic_load_explicit(&q->tail, memory_order_acquire);
+}
+
+void print(spsc_queue* q) {
+    printf("QUEUE: [ ");
+    size_t tail = atomic_load(&q->tail);
+    for (size_t i = atomic_load(&q->head); i != tail; i++) {
+        printf("%d ", q->elements[i & q->mask]);
+    }
+    printf("]\n");
+}
+
+// 比較用の、queue_array.c の queue を mutex で保護したものです。
+typedef struct {
+    int head;
+    int tail;
+    int count;
+    int elements[CAPACITY];
+    pthread_mutex_t lock;
+} locked_queue;
+
+bool locked_enqueue(locked_queue* q, int val) {
+    pthread_mutex_lock(&q->lock);
+    bool ok = q->count < CAPACITY;
+    if (ok) {
+        q->elements[q->tail] = val;
+        q->tail++;
+        if (q->tail >= CAPACITY) {
+            q->tail = 0;
+        }
+        q->count++;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+bool locked_dequeue(locked_queue* q, int* val) {
+    pthread_mutex_lock(&q->lock);
+    bool ok = q->count > 0;
+    if (ok) {
+        *val = q->elements[q->head];
+        q->head++;
+        if (q->head >= CAPACITY) {
+            q->head = 0;
+        }
+        q->count--;
+    }
+    pthread_mutex_unlock(&q->lock);
+    return ok;
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 失敗が続いたら CPU を譲ります。
+static inline void backoff(int* failures) {
+    if (++*failures >= SPIN) {
+        sched_yield();
+        *failures = 0;
+    }
+}
+
+// 計測の種類です。
+typedef enum {
+    SINGLE,
+    BATCHED,
+    LOCKED,
+} mode;
+
+typedef struct {
+    mode m;
+    spsc_queue* q;
+    locked_queue* lq;
+} channel;
+
+// 生産者は 0, 1, 2, ... を順番に送ります。
+void* producer_main(void* arg) {
+    channel* ch = (channel*)arg;
+    int failures = 0;
+    if (ch->m == BATCHED) {
+        int values[BATCH];
+        for (int sent = 0; sent < NUM_MESSAGES;) {
+            int n = NUM_MESSAGES - sent < BATCH ? NUM_MESSAGES - sent : BATCH;
+            for (int i = 0; i < n; i++) {
+                values[i] = sent + i;
+            }
+            int done = 0;
+            while (done < n) {
+                size_t k = enqueue_n(ch->q, values + done, n - done);
+                done += (int)k;
+                if (k == 0) {
+                    backoff(&failures);
+                }
+            }
+            sent += n;
+        }
+        return NULL;
+    }
+    for (int i = 0; i < NUM_MESSAGES; i++) {
+        while (!(ch->m == SINGLE ? enqueue(ch->q, i) : locked_enqueue(ch->lq, i))) {
+            backoff(&failures);
+        }
+    }
+    return NULL;
+}
+
+// 消費者は受け取った値が順番通りであることを確認します。
+void consume(channel* ch) {
+    int failures = 0;
+    int expected = 0;
+    if (ch->m == BATCHED) {
+        int values[BATCH];
+        while (expected < NUM_MESSAGES) {
+            size_t n = dequeue_n(ch->q, values, BATCH);
+            if (n == 0) {
+                backoff(&failures);
+            }
+            for (size_t i = 0; i < n; i++) {
+                assert(values[i] == expected);
+                expected++;
+            }
+        }
+        return;
+    }
+    while (expected < NUM_MESSAGES) {
+        int val;
+        if (ch->m == SINGLE ? dequeue(ch->q, &val) : locked_dequeue(ch->lq, &val)) {
+            assert(val == expected);
+            expected++;
+        } else {
+            backoff(&failures);
+        }
+    }
+}
+
+// 1 秒あたりのメッセージ数を返します。
+double throughput(mode m) {
+    spsc_queue q;
+    init(&q, CAPACITY);
+    locked_queue lq = {0, 0, 0, {0}, PTHREAD_MUTEX_INITIALIZER};
+    channel ch = {m, &q, &lq};
+
+    double start = now();
+    pthread_t producer;
+    pthread_create(&producer, NULL, producer_main, &ch);
+    consume(&ch);
+    pthread_join(producer, NULL);
+    double elapsed = now() - start;
+
+    destroy(&q);
+    return NUM_MESSAGES / elapsed;
+}
+
+// レイテンシは 2 つの queue でメッセージを往復させて (ping-pong) 測ります。
+// 片道の時間は往復の時間の半分です。
+typedef struct {
+    spsc_queue* ping;
+    spsc_queue* pong;
+} ping_pong;
+
+void* echo_main(void* arg) {
+    ping_pong* p = (ping_pong*)arg;
+    int failures = 0;
+    for (int i = 0; i < NUM_PINGS; i++) {
+        int val;
+        while (!dequeue(p->ping, &val)) {
+            backoff(&failures);
+        }
+        while (!enqueue(p->pong, val)) {
+            backoff(&failures);
+        }
+    }
+    return NULL;
+}
+
+int compare_double(const void* a, const void* b) {
+    double x = *(const double*)a;
+    double y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+void latency(double* p50, double* p99) {
+    spsc_queue ping;
+    spsc_queue pong;
+    init(&ping, CAPACITY);
+    init(&pong, CAPACITY);
+    ping_pong p = {&ping, &pong};
+    double* samples = (double*)malloc(NUM_PINGS * sizeof(double));
+
+    pthread_t echo;
+    pthread_create(&echo, NULL, echo_main, &p);
+    int failures = 0;
+    for (int i = 0; i < NUM_PINGS; i++) {
+        double start = now();
+        while (!enqueue(&ping, i)) {
+            backoff(&failures);
+        }
+        int val;
+        while (!dequeue(&pong, &val)) {
+            backoff(&failures);
+        }
+        assert(val == i);
+        samples[i] = (now() - start) / 2 * 1e9;
+    }
+    pthread_join(echo, NULL);
+
+    qsort(samples, NUM_PINGS, sizeof(double), compare_double);
+    *p50 = samples[NUM_PINGS / 2];
+    *p99 = samples[(long long)NUM_PINGS * 99 / 100];
+    free(samples);
+    destroy(&ping);
+    destroy(&pong);
+}
+
+int main() {
+    // queue_array.c と同じ操作を 1 つのスレッドで確認します。
+    spsc_queue q;
+    init(&q, 8);
+    for (int i = 0; i < 10; i++) {
+        if (!enqueue(&q, i)) {
+            printf("FULL: %d\n", i);
+        }
+    }
+    print(&q);
+
+    int val;
+    dequeue(&q, &val);
+    printf("DEQUEUE: %d\n", val);
+    print(&q);
+
+    int values[] = {100, 101, 102, 103};
+    printf("ENQUEUE_N: %zu\n", enqueue_n(&q, values, 4));
+    print(&q);
+
+    int out[16];
+    printf("DEQUEUE_N: %zu\n", dequeue_n(&q, out, 16));
+    print(&q);
+    destroy(&q);
+
+    printf("\nsizeof(spsc_queue) = %zu, offsetof tail = %zu, head = %zu\n", sizeof(spsc_queue),
+           (size_t)((char*)&q.tail - (char*)&q), (size_t)((char*)&q.head - (char*)&q));
+    printf("%-24s %14s\n", "two threads", "messages/s");
+    printf("%-24s %14.0lf\n", "locked queue_array", throughput(LOCKED));
+    printf("%-24s %14.0lf\n", "spsc enqueue/dequeue", throughput(SINGLE));
+    printf("%-24s %14.0lf\n", "spsc enqueue_n/dequeue_n", throughput(BATCHED));
+
+    double p50;
+    double p99;
+    latency(&p50, &p99);
+    printf("one-way latency (ping-pong / 2): p50 %.0lf ns, p99 %.0lf ns\n", p50, p99);
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// CPU が 1 コアの環境で実行したため、2 つのスレッドは交互に動いています。
+// レイテンシにはスレッドの切り替えの時間が含まれます。
+// FULL: 8
+// FULL: 9
+// QUEUE: [ 0 1 2 3 4 5 6 7 ]
+// DEQUEUE: 0
+// QUEUE: [ 1 2 3 4 5 6 7 ]
+// ENQUEUE_N: 1
+// QUEUE: [ 1 2 3 4 5 6 7 100 ]
+// DEQUEUE_N: 8
+// QUEUE: [ ]
+//
+// sizeof(spsc_queue) = 192, offsetof tail = 64, head = 128
+// two threads                  messages/s
+// locked queue_array             20192907
+// spsc enqueue/dequeue          105629167
+// spsc enqueue_n/dequeue_n      174262815
+// one-way latency (ping-pong / 2): p50 1252 ns, p99 1352 ns
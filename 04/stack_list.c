@@ -3,11 +3,24 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../03/pool_allocator.h"
+
 typedef struct cell_ {
     int element;
     struct cell_* next;
 } cell;
 
+// cell は malloc ではなく 03/pool_allocator.h のプールから確保します。
+pool cell_pool;
+
+cell* new_cell() {
+    return (cell*)pool_alloc(&cell_pool);
+}
+
+void delete_cell(cell* c) {
+    pool_free(&cell_pool, c);
+}
+
 typedef struct
 {
     cell* head;
@@ -17,14 +30,14 @@ void clear(stack* s) {
     cell* current = s->head;
     while (current != NULL) {
         cell* next = current->next;
-        free(current);
+        delete_cell(current);
         current = next;
     }
     s->head = NULL;
 }
 
 void push(stack* s, int val) {
-    cell* c = (cell*)malloc(sizeof(cell));
+    cell* c = new_cell();
     c->element = val;
     c->next = s->head;
     s->head = c;
@@ -37,7 +50,7 @@ int pop(stack* s) {
     int val = s->head->element;
     cell* c = s->head;
     s->head = s->head->next;
-    free(c);
+    delete_cell(c);
     return val;
 }
 
@@ -52,6 +65,7 @@ void print(stack* s) {
 }
 
 int main() {
+    pool_init(&cell_pool, sizeof(cell), OBJECTS_PER_SLAB);
     stack s = {NULL};
 
     for (int i = 0; i < 10; i++) {
@@ -63,6 +77,7 @@ int main() {
     print(&s);
 
     clear(&s);
+    pool_destroy(&cell_pool);
     return 0;
 }
 
@@ -0,0 +1,530 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_NODES 10000000
+#define OUTPUT_SIZE (1 << 16)
+
+// binary_tree.c の走査と clear は再帰関数なので、一直線に伸びた木のように
+// 深さが大きい木ではコールスタックが溢れてしまいます。
+// ここでは再帰を使わない走査と clear を実装します。
+// 1. 明示的なスタック (配列) を使う走査
+// 2. Morris traversal: 空いている right ポインタに一時的に戻り先を書き込むことで、
+//    スタックを使わずに O(1) の追加領域で走査します。走査中は木を書き換えるので、
+//    他のスレッドが同時に木を読んではいけません。
+// また、1 ノードごとに printf を呼ぶと走査よりも stdio の方が遥かに時間がかかるので、
+// 走査とは別に、訪れたノードを関数 (visitor) に渡すようにし、
+// 出力する場合はバッファにまとめてから fwrite します。
+typedef struct node_ {
+    char element;
+    struct node_* left;
+    struct node_* right;
+} node;
+
+node* init_node(char element) {
+    node* n = (node*)malloc(sizeof(node));
+    n->element = element;
+    n->left = NULL;
+    n->right = NULL;
+    return n;
+}
+
+typedef void (*visitor)(node* n, void* context);
+
+// 比較用の、binary_tree.c の再帰関数をそのまま持ってきたものです。
+void clear(node** p_current) {
+    node* current = *p_current;
+    if (current != NULL) {
+        clear(&current->left);
+        clear(&current->right);
+        free(current);
+        *p_current = NULL;
+    }
+}
+
+void pre_order(node* p) {
+    if (p != NULL) {
+        printf("%c ", p->element);
+        pre_order(p->left);
+        pre_order(p->right);
+    }
+}
+
+// 上の再帰関数の printf を visitor に置き換えたものです。
+void pre_order_recursive(node* p, visitor visit, void* context) {
+    if (p != NULL) {
+        visit(p, context);
+        pre_order_recursive(p->left, visit, context);
+        pre_order_recursive(p->right, visit, context);
+    }
+}
+
+void in_order_recursive(node* p, visitor visit, void* context) {
+    if (p != NULL) {
+        in_order_recursive(p->left, visit, context);
+        visit(p, context);
+        in_order_recursive(p->right, visit, context);
+    }
+}
+
+void post_order_recursive(node* p, visitor visit, void* context) {
+    if (p != NULL) {
+        post_order_recursive(p->left, visit, context);
+        post_order_recursive(p->right, visit, context);
+        visit(p, context);
+    }
+}
+
+// 走査に使うスタックです。足りなくなったら 2 倍に広げます。
+typedef struct {
+    node** elements;
+    int length;
+    int capacity;
+} node_stack;
+
+void stack_init(node_stack* s) {
+    s->capacity = 64;
+    s->elements = (node**)malloc(s->capacity * sizeof(node*));
+    s->length = 0;
+}
+
+void stack_clear(node_stack* s) {
+    free(s->elements);
+    s->elements = NULL;
+    s->length = 0;
+    s->capacity = 0;
+}
+
+static inline void stack_push(node_stack* s, node* n) {
+    if (s->length == s->capacity) {
+        s->capacity *= 2;
+        s->elements = (node**)realloc(s->elements, s->capacity * sizeof(node*));
+    }
+    s->elements[s->length++] = n;
+}
+
+static inline node* stack_pop(node_stack* s) {
+    return s->elements[--s->length];
+}
+
+// 右の子を先に push しておくことで、左の部分木を先に訪れます。
+void pre_order_iterative(node* root, visitor visit, void* context) {
+    node_stack s;
+    stack_init(&s);
+    node* current = root;
+    while (current != NULL) {
+        visit(current, context);
+        if (current->right != NULL) {
+            stack_push(&s, current->right);
+        }
+        if (current->left != NULL) {
+            current = current->left;
+        } else {
+            current = s.length > 0 ? stack_pop(&s) : NULL;
+        }
+    }
+    stack_clear(&s);
+}
+
+// 左の子をたどれるところまでたどりながら push し、
+// 行き止まったら pop したノードを訪れてその右の部分木に移ります。
+void in_order_iterative(node* root, visitor visit, void* context) {
+    node_stack s;
+    stack_init(&s);
+    node* current = root;
+    while (current != NULL || s.length > 0) {
+        while (current != NULL) {
+            stack_push(&s, current);
+            current = current->left;
+        }
+        current = stack_pop(&s);
+        visit(current, context);
+        current = current->right;
+    }
+    stack_clear(&s);
+}
+
+// 帰りがけ順では、右の部分木を訪れ終えてから親を訪れるので、
+// スタックの一番上のノードについて、右の部分木から戻ってきたところかどうかを
+// 直前に訪れたノード (last) で判断します。
+void post_order_iterative(node* root, visitor visit, void* context) {
+    node_stack s;
+    stack_init(&s);
+    node* current = root;
+    node* last = NULL;
+    while (current != NULL || s.length > 0) {
+        while (current != NULL) {
+            stack_push(&s, current);
+            current = current->left;
+        }
+        node* top = s.elements[s.length - 1];
+        if (top->right != NULL && top->right != last) {
+            current = top->right;
+        } else {
+            visit(top, context);
+            last = stack_pop(&s);
+        }
+    }
+    stack_clear(&s);
+}
+
+// current の左の部分木で最も右にあるノード (通りがけ順で current の直前のノード) を返します。
+// その right が既に current を指している場合 (戻り先を書き込んだ後) はそこで止まります。
+static inline node* predecessor(node* current) {
+    node* p = current->left;
+    while (p->right != NULL && p->right != current) {
+        p = p->right;
+    }
+    return p;
+}
+
+// 左の部分木に入る前に、その部分木の最後のノードの right に current を書き込んでおきます。
+// 左の部分木を訪れ終えるとその right をたどって current に戻ってくるので、
+// 2 回目に current に来たときに書き込んだ right を NULL に戻します。
+void in_order_morris(node* root, visitor visit, void* context) {
+    node* current = root;
+    while (current != NULL) {
+        if (current->left == NULL) {
+            visit(current, context);
+            current = current->right;
+            continue;
+        }
+        node* p = predecessor(current);
+        if (p->right == NULL) {
+            p->right = current;
+            current = current->left;
+        } else {
+            p->right = NULL;
+            visit(current, context);
+            current = current->right;
+        }
+    }
+}
+
+// in_order_morris と同じ手順で、1 回目に来たときに訪れます。
+void pre_order_morris(node* root, visitor visit, void* context) {
+    node* current = root;
+    while (current != NULL) {
+        if (current->left == NULL) {
+            visit(current, context);
+            current = current->right;
+            continue;
+        }
+        node* p = predecessor(current);
+        if (p->right == NULL) {
+            visit(current, context);
+            p->right = current;
+            current = current->left;
+        } else {
+            p->right = NULL;
+            current = current->right;
+        }
+    }
+}
+
+// from から right をたどって to までの向きを逆にします。
+static void reverse_right(node* from, node* to) {
+    if (from == to) {
+        return;
+    }
+    node* previous = from;
+    node* current = from->right;
+    while (previous != to) {
+        node* next = current->right;
+        current->right = previous;
+        previous = current;
+        current = next;
+    }
+}
+
+// 帰りがけ順では、2 回目に current に来たときに、左の子から right をたどって
+// p に至る経路を逆順に訪れます。その経路の right を一時的に逆向きにして
+// p から左の子までたどり、訪れた後で元に戻します。
+// 根の右側の経路も同じ方法で訪れるため、根を左の子に持つ仮のノードから始めます。
+void post_order_morris(node* root, visitor visit, void* context) {
+    node dummy = {0, root, NULL};
+    node* current = &dummy;
+    while (current != NULL) {
+        if (current->left == NULL) {
+            current = current->right;
+            continue;
+        }
+        node* p = predecessor(current);
+        if (p->right == NULL) {
+            p->right = current;
+            current = current->left;
+        } else {
+            reverse_right(current->left, p);
+            for (node* n = p;; n = n->right) {
+                visit(n, context);
+                if (n == current->left) {
+                    break;
+                }
+            }
+            reverse_right(p, current->left);
+            p->right = NULL;
+            current = current->right;
+        }
+    }
+}
+
+// 再帰を使わない clear です。
+// 根に左の子があれば右回転して左の子を根にし、無ければ根を解放して右の子に移ります。
+// 右回転では、左の子の右の部分木を元の根の左につなぎ直すので、
+// 追加の領域を使わずに、各ノードを高々 2 回たどるだけで全体を解放できます。
+void clear_iterative(node** p_root) {
+    node* current = *p_root;
+    while (current != NULL) {
+        if (current->left != NULL) {
+            node* left = current->left;
+            current->left = left->right;
+            left->right = current;
+            current = left;
+        } else {
+            node* right = current->right;
+            free(current);
+            current = right;
+        }
+    }
+    *p_root = NULL;
+}
+
+// 訪れたノードの要素を出力用のバッファに溜め、一杯になったらまとめて fwrite します。
+typedef struct {
+    FILE* file;
+    size_t length;
+    char data[OUTPUT_SIZE];
+} output;
+
+void flush(output* out) {
+    fwrite(out->data, 1, out->length, out->file);
+    out->length = 0;
+}
+
+void write_element(node* n, void* context) {
+    output* out = (output*)context;
+    if (out->length + 2 > OUTPUT_SIZE) {
+        flush(out);
+    }
+    out->data[out->length++] = n->element;
+    out->data[out->length++] = ' ';
+}
+
+// binary_tree.c と同じく 1 ノードごとに stdio で出力します。
+void print_element(node* n, void* context) {
+    fprintf((FILE*)context, "%c ", n->element);
+}
+
+// 訪れた順番によって値が変わるハッシュ値を計算します。
+void hash_element(node* n, void* context) {
+    uint64_t* hash = (uint64_t*)context;
+    *hash = *hash * 31 + n->element;
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 深さが log2(length) 程度の完全二分木を作ります。nodes[i] の子は nodes[2i+1] と nodes[2i+2] です。
+node* build_balanced(int length) {
+    node** nodes = (node**)malloc(length * sizeof(node*));
+    for (int i = 0; i < length; i++) {
+        nodes[i] = init_node((char)('a' + i % 26));
+    }
+    for (int i = 0; i < length; i++) {
+        if (2 * i + 1 < length) {
+            nodes[i]->left = nodes[2 * i + 1];
+        }
+        if (2 * i + 2 < length) {
+            nodes[i]->right = nodes[2 * i + 2];
+        }
+    }
+    node* root = nodes[0];
+    free(nodes);
+    return root;
+}
+
+// 深さが length の一直線の木を作ります。左右の子を交互にたどります。
+node* build_chain(int length) {
+    node* root = init_node('a');
+    node* current = root;
+    for (int i = 1; i < length; i++) {
+        node* n = init_node((char)('a' + i % 26));
+        if (i % 2 == 0) {
+            current->left = n;
+        } else {
+            current->right = n;
+        }
+        current = n;
+    }
+    return root;
+}
+
+typedef void (*traversal)(node* root, visitor visit, void* context);
+
+typedef struct {
+    const char* name;
+    traversal orders[3];
+    // 深い木ではコールスタックが溢れるので計測しません。
+    bool recursive;
+} method;
+
+// 1 ノードあたりの時間 (ns) を返します。hash には訪れた順番のハッシュ値を返します。
+double measure_hash(traversal order, node* root, uint64_t* hash) {
+    *hash = 0;
+    double start = now();
+    order(root, hash_element, hash);
+    return (now() - start) * 1e9 / NUM_NODES;
+}
+
+double measure_output(traversal order, node* root, FILE* file) {
+    output* out = (output*)malloc(sizeof(output));
+    out->file = file;
+    out->length = 0;
+    double start = now();
+    order(root, write_element, out);
+    flush(out);
+    fflush(file);
+    double elapsed = (now() - start) * 1e9 / NUM_NODES;
+    free(out);
+    return elapsed;
+}
+
+void benchmark(const char* shape, node* root, bool deep, FILE* null_output) {
+    method methods[] = {
+        {"recursive", {pre_order_recursive, in_order_recursive, post_order_recursive}, true},
+        {"stack", {pre_order_iterative, in_order_iterative, post_order_iterative}, false},
+        {"morris", {pre_order_morris, in_order_morris, post_order_morris}, false},
+    };
+    uint64_t expected[3];
+
+    printf("%-8s %-20s", shape, "recursive + fprintf");
+    for (int o = 0; o < 3; o++) {
+        if (deep) {
+            printf(" %10s", "-");
+            continue;
+        }
+        double start = now();
+        methods[0].orders[o](root, print_element, null_output);
+        fflush(null_output);
+        printf(" %10.2lf", (now() - start) * 1e9 / NUM_NODES);
+    }
+    printf("\n");
+
+    for (int m = 0; m < 3; m++) {
+        printf("%-8s %-20s", shape, methods[m].name);
+        for (int o = 0; o < 3; o++) {
+            if (deep && methods[m].recursive) {
+                printf(" %10s", "-");
+                continue;
+            }
+            uint64_t hash;
+            printf(" %10.2lf", measure_hash(methods[m].orders[o], root, &hash));
+            if (m == 0 || (deep && m == 1)) {
+                expected[o] = hash;
+            }
+            assert(hash == expected[o]);
+        }
+        printf("\n");
+    }
+
+    printf("%-8s %-20s", shape, "stack + buffer");
+    for (int o = 0; o < 3; o++) {
+        printf(" %10.2lf", measure_output(methods[1].orders[o], root, null_output));
+    }
+    printf("\n");
+}
+
+int main() {
+    node* root = init_node('*');
+    root->left = init_node('+');
+    root->right = init_node('-');
+    root->left->left = init_node('a');
+    root->left->right = init_node('b');
+    root->right->left = init_node('c');
+    root->right->right = init_node('/');
+    root->right->right->left = init_node('d');
+    root->right->right->right = init_node('e');
+
+    // binary_tree.c と同じ出力を、それぞれの方法で確認します。
+    traversal orders[][3] = {
+        {pre_order_iterative, in_order_iterative, post_order_iterative},
+        {pre_order_morris, in_order_morris, post_order_morris},
+    };
+    for (int m = 0; m < 2; m++) {
+        for (int o = 0; o < 3; o++) {
+            output* out = (output*)malloc(sizeof(output));
+            out->file = stdout;
+            out->length = 0;
+            printf("TREE: [ ");
+            fflush(stdout);
+            orders[m][o](root, write_element, out);
+            flush(out);
+            printf("]\n");
+            free(out);
+        }
+    }
+
+    clear_iterative(&root);
+    printf("TREE: [ ");
+    pre_order(root);
+    printf("]\n");
+
+    FILE* null_output = fopen("/dev/null", "w");
+    assert(null_output != NULL);
+
+    printf("\nNUM_NODES = %d\n", NUM_NODES);
+    printf("%-8s %-20s %10s %10s %10s   (ns / node)\n", "tree", "method", "pre", "in", "post");
+    root = build_balanced(NUM_NODES);
+    benchmark("balanced", root, false, null_output);
+    double start = now();
+    clear(&root);
+    double recursive_clear = (now() - start) * 1e9 / NUM_NODES;
+    root = build_balanced(NUM_NODES);
+    start = now();
+    clear_iterative(&root);
+    double iterative_clear = (now() - start) * 1e9 / NUM_NODES;
+    printf("%-8s %-20s %10.2lf (recursive) %10.2lf (iterative)\n", "balanced", "clear", recursive_clear,
+           iterative_clear);
+
+    root = build_chain(NUM_NODES);
+    benchmark("chain", root, true, null_output);
+    start = now();
+    clear_iterative(&root);
+    iterative_clear = (now() - start) * 1e9 / NUM_NODES;
+    printf("%-8s %-20s %10s (recursive) %10.2lf (iterative)\n", "chain", "clear", "-", iterative_clear);
+
+    fclose(null_output);
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// TREE: [ * + a b - c / d e ]
+// TREE: [ a + b * c - d / e ]
+// TREE: [ a b + c d e / - * ]
+// TREE: [ * + a b - c / d e ]
+// TREE: [ a + b * c - d / e ]
+// TREE: [ a b + c d e / - * ]
+// TREE: [ ]
+//
+// NUM_NODES = 10000000
+// tree     method                      pre         in       post   (ns / node)
+// balanced recursive + fprintf       59.35      62.23      55.22
+// balanced recursive                  5.27       5.80       4.55
+// balanced stack                      6.11       6.43       7.16
+// balanced morris                    14.50      14.00      15.52
+// balanced stack + buffer             6.39       6.85       7.27
+// balanced clear                     14.59 (recursive)      15.80 (iterative)
+// chain    recursive + fprintf           -          -          -
+// chain    recursive                     -          -          -
+// chain    stack                      6.46       8.26      17.84
+// chain    morris                    11.31      10.11      12.26
+// chain    stack + buffer             7.32       9.66      17.38
+// chain    clear                         - (recursive)      14.90 (iterative)
@@ -0,0 +1,495 @@
+#include <assert.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_OPERATIONS (1 << 22)
+#define STRESS_OPERATIONS (1 << 16)
+#define CAPACITY 1024
+#define CACHE_LINE 64
+#define MAX_THREADS 8
+// 1 回の elimination で相手を待つ回数です。
+#define ELIMINATION_SPIN 128
+#define ELIMINATION_SIZE 8
+// データ (または空き) が無いときに、この回数だけ再試行してから sched_yield で CPU を譲ります。
+#define SPIN 64
+
+// 複数のスレッドが同時に push と pop をできる、ロックを使わない stack です (Treiber stack)。
+// head を CAS で付け替えるだけで push と pop ができますが、そのままでは ABA 問題があります。
+// pop するスレッドが head == A, A->next == B を読んでから CAS するまでの間に、
+// 他のスレッドが A と B を pop して A だけを push し直すと、head は再び A になるので
+// CAS は成功してしまい、既に取り除かれた B が head になります。
+//
+// 128 bit の CAS を使うと gcc では libatomic が必要になるので、ここでは
+// cell を配列から割り当て、head にはポインタの代わりに 32 bit の添字を入れ、
+// 残りの 32 bit に CAS のたびに 1 増える tag を入れます。
+// 上の例では A を push し直したときに tag が変わるため、CAS は失敗します。
+// (tag が 2^32 回進んで一周するまで CAS を待たされることは無いものとします。)
+// cell は free しないので、他のスレッドが pop した cell の next を読んでも安全です。
+//
+// 空いている cell も同じ形の stack (free_cells) に入れておきます。
+// push は free_cells から cell を 1 つ pop して値を書き、items に push します。
+// pop は items から pop して値を読み、cell を free_cells に push します。
+typedef struct {
+    int element;
+    _Atomic uint32_t next;
+} cell;
+
+#define NIL UINT32_MAX
+
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic uint64_t head;
+} cell_list;
+
+// elimination backoff 用の交換場所です。
+// CAS に失敗した push と pop は、stack を通さずにここで値を直接受け渡します。
+// 上位 32 bit が状態で、OFFER のときは下位 32 bit に push する値が入っています。
+#define EXCHANGER_EMPTY 0
+#define EXCHANGER_OFFER (1ull << 32)
+#define EXCHANGER_TAKEN (2ull << 32)
+
+typedef struct {
+    _Alignas(CACHE_LINE) _Atomic uint64_t value;
+} exchanger;
+
+typedef struct {
+    cell* cells;
+    cell_list items;
+    cell_list free_cells;
+    bool elimination;
+    exchanger exchangers[ELIMINATION_SIZE];
+} stack;
+
+static inline uint64_t pack(uint32_t tag, uint32_t index) {
+    return (uint64_t)tag << 32 | index;
+}
+
+static inline uint32_t tag_of(uint64_t head) {
+    return (uint32_t)(head >> 32);
+}
+
+static inline uint32_t index_of(uint64_t head) {
+    return (uint32_t)head;
+}
+
+// 1 回だけ CAS を試みます。他のスレッドと競合して失敗したら false を返します。
+static bool try_push_cell(cell_list* l, cell* cells, uint32_t index) {
+    uint64_t old = atomic_load(&l->head);
+    atomic_store_explicit(&cells[index].next, index_of(old), memory_order_relaxed);
+    return atomic_compare_exchange_strong(&l->head, &old, pack(tag_of(old) + 1, index));
+}
+
+static void push_cell(cell_list* l, cell* cells, uint32_t index) {
+    while (!try_push_cell(l, cells, index)) {
+    }
+}
+
+typedef enum { POP_SUCCESS, POP_EMPTY, POP_CONFLICT } pop_result;
+
+// 1 回だけ CAS を試みます。
+static pop_result try_pop_cell(cell_list* l, cell* cells, uint32_t* index) {
+    uint64_t old = atomic_load(&l->head);
+    uint32_t top = index_of(old);
+    if (top == NIL) {
+        return POP_EMPTY;
+    }
+    // top は他のスレッドによって既に pop され、next が書き換えられているかもしれませんが、
+    // その場合は tag が変わっているので下の CAS が失敗します。
+    uint32_t next = atomic_load_explicit(&cells[top].next, memory_order_relaxed);
+    if (!atomic_compare_exchange_strong(&l->head, &old, pack(tag_of(old) + 1, next))) {
+        return POP_CONFLICT;
+    }
+    *index = top;
+    return POP_SUCCESS;
+}
+
+// 空ならば false を返します。
+static bool pop_cell(cell_list* l, cell* cells, uint32_t* index) {
+    while (true) {
+        pop_result result = try_pop_cell(l, cells, index);
+        if (result != POP_CONFLICT) {
+            return result == POP_SUCCESS;
+        }
+    }
+}
+
+void init(stack* s, uint32_t capacity, bool elimination) {
+    s->cells = (cell*)malloc(capacity * sizeof(cell));
+    for (uint32_t i = 0; i < capacity; i++) {
+        atomic_init(&s->cells[i].next, i + 1 < capacity ? i + 1 : NIL);
+    }
+    atomic_init(&s->items.head, pack(0, NIL));
+    atomic_init(&s->free_cells.head, pack(0, 0));
+    s->elimination = elimination;
+    for (int i = 0; i < ELIMINATION_SIZE; i++) {
+        atomic_init(&s->exchangers[i].value, EXCHANGER_EMPTY);
+    }
+}
+
+// 他のスレッドが使っていないときに呼び出します。
+void destroy(stack* s) {
+    free(s->cells);
+    s->cells = NULL;
+}
+
+// 呼び出した時点で空だったかどうかを返します。
+bool empty(stack* s) {
+    return index_of(atomic_load(&s->items.head)) == NIL;
+}
+
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+_Thread_local uint64_t exchanger_state = 88172645463325252ull;
+_Thread_local long long num_eliminated = 0;
+
+static inline exchanger* random_exchanger(stack* s) {
+    return &s->exchangers[xorshift64(&exchanger_state) % ELIMINATION_SIZE];
+}
+
+// push 側です。交換場所に値を置き、pop 側が取りに来るのをしばらく待ちます。
+// 受け渡せたら true を返します。
+static bool eliminate_push(stack* s, int val) {
+    _Atomic uint64_t* slot = &random_exchanger(s)->value;
+    uint64_t offer = EXCHANGER_OFFER | (uint32_t)val;
+    uint64_t expected = EXCHANGER_EMPTY;
+    if (!atomic_compare_exchange_strong(slot, &expected, offer)) {
+        return false;
+    }
+    for (int i = 0; i < ELIMINATION_SPIN; i++) {
+        if (atomic_load_explicit(slot, memory_order_acquire) == EXCHANGER_TAKEN) {
+            atomic_store(slot, EXCHANGER_EMPTY);
+            num_eliminated++;
+            return true;
+        }
+    }
+    // 取り下げます。失敗した場合は直前に取られています。
+    expected = offer;
+    if (atomic_compare_exchange_strong(slot, &expected, EXCHANGER_EMPTY)) {
+        return false;
+    }
+    atomic_store(slot, EXCHANGER_EMPTY);
+    num_eliminated++;
+    return true;
+}
+
+// pop 側です。交換場所に push 側の値があれば取ります。
+static bool eliminate_pop(stack* s, int* val) {
+    _Atomic uint64_t* slot = &random_exchanger(s)->value;
+    uint64_t current = atomic_load(slot);
+    if ((current & ~(uint64_t)UINT32_MAX) != EXCHANGER_OFFER) {
+        return false;
+    }
+    if (!atomic_compare_exchange_strong(slot, &current, EXCHANGER_TAKEN)) {
+        return false;
+    }
+    *val = (int)(uint32_t)current;
+    return true;
+}
+
+// 満杯ならば false を返します。
+bool try_push(stack* s, int val) {
+    uint32_t index;
+    if (!pop_cell(&s->free_cells, s->cells, &index)) {
+        return false;
+    }
+    s->cells[index].element = val;
+    while (!try_push_cell(&s->items, s->cells, index)) {
+        // 競合したので、head から離れた場所で pop 側と直接受け渡すことを試みます。
+        if (s->elimination && eliminate_push(s, val)) {
+            push_cell(&s->free_cells, s->cells, index);
+            return true;
+        }
+    }
+    return true;
+}
+
+// 空ならば false を返します。
+bool try_pop(stack* s, int* val) {
+    while (true) {
+        uint32_t index;
+        pop_result result = try_pop_cell(&s->items, s->cells, &index);
+        if (result == POP_SUCCESS) {
+            *val = s->cells[index].element;
+            push_cell(&s->free_cells, s->cells, index);
+            return true;
+        }
+        if (result == POP_EMPTY) {
+            return false;
+        }
+        if (s->elimination && eliminate_pop(s, val)) {
+            return true;
+        }
+    }
+}
+
+// 失敗が続いたら CPU を譲ります。
+static inline void backoff(int* failures) {
+    if (++*failures >= SPIN) {
+        sched_yield();
+        *failures = 0;
+    }
+}
+
+// stack_list.c の push と同じ形です。満杯の間は空くまで待ちます。
+void push(stack* s, int val) {
+    int failures = 0;
+    while (!try_push(s, val)) {
+        backoff(&failures);
+    }
+}
+
+// stack_list.c の pop と同じ形です。
+// 複数のスレッドがある場合は empty で確認してから pop しても
+// その間に他のスレッドに取られることがあるため、assert ではなく
+// 値が入るまで待ちます。
+int pop(stack* s) {
+    int failures = 0;
+    int val;
+    while (!try_pop(s, &val)) {
+        backoff(&failures);
+    }
+    return val;
+}
+
+void print(stack* s) {
+    printf("LIST: [ ");
+    uint32_t current = index_of(atomic_load(&s->items.head));
+    while (current != NIL) {
+        printf("%d ", s->cells[current].element);
+        current = atomic_load(&s->cells[current].next);
+    }
+    printf("]\n");
+}
+
+// 比較用の、stack_list.c の stack を mutex で保護したものです。
+typedef struct plain_cell_ {
+    int element;
+    struct plain_cell_* next;
+} plain_cell;
+
+typedef struct {
+    plain_cell* head;
+    pthread_mutex_t lock;
+} locked_stack;
+
+void locked_push(locked_stack* s, int val) {
+    plain_cell* c = (plain_cell*)malloc(sizeof(plain_cell));
+    c->element = val;
+
+    pthread_mutex_lock(&s->lock);
+    c->next = s->head;
+    s->head = c;
+    pthread_mutex_unlock(&s->lock);
+}
+
+int locked_pop(locked_stack* s) {
+    pthread_mutex_lock(&s->lock);
+    plain_cell* c = s->head;
+    assert(c != NULL);
+    s->head = c->next;
+    pthread_mutex_unlock(&s->lock);
+
+    int val = c->element;
+    free(c);
+    return val;
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    stack* s;
+    locked_stack* ls;
+    int num_threads;
+    // 以下は stress test 用です。
+    atomic_uchar* popped;
+    atomic_llong eliminated;
+} shared;
+
+typedef struct {
+    shared* sh;
+    int index;
+} worker;
+
+// 各スレッドは 1 から 8 個の値を push し、同じ個数を pop することを繰り返します。
+// push した値は全体で重複しないようにしておき、pop した値に印を付けます。
+// 自分が push した個数だけ pop するので、pop の時点で stack は空になりません。
+void* stress_main(void* arg) {
+    worker* w = (worker*)arg;
+    shared* sh = w->sh;
+    uint64_t state = 88172645463325252ull + w->index;
+    exchanger_state = state * 2 + 1;
+    num_eliminated = 0;
+    int begin = w->index * STRESS_OPERATIONS;
+    int i = 0;
+    while (i < STRESS_OPERATIONS) {
+        int n = 1 + (int)(xorshift64(&state) % 8);
+        if (n > STRESS_OPERATIONS - i) {
+            n = STRESS_OPERATIONS - i;
+        }
+        for (int k = 0; k < n; k++) {
+            push(sh->s, begin + i + k);
+        }
+        for (int k = 0; k < n; k++) {
+            int val = pop(sh->s);
+            assert(0 <= val && val < sh->num_threads * STRESS_OPERATIONS);
+            atomic_fetch_add(&sh->popped[val], 1);
+        }
+        i += n;
+    }
+    atomic_fetch_add(&sh->eliminated, num_eliminated);
+    return NULL;
+}
+
+// すべての値がちょうど 1 回ずつ pop されたことを確認し、elimination で受け渡された数を返します。
+long long stress(int num_threads, bool elimination) {
+    stack s;
+    init(&s, CAPACITY, elimination);
+    shared sh = {&s, NULL, num_threads, NULL, 0};
+    sh.popped = (atomic_uchar*)calloc((size_t)num_threads * STRESS_OPERATIONS, sizeof(atomic_uchar));
+
+    pthread_t threads[MAX_THREADS];
+    worker workers[MAX_THREADS];
+    for (int i = 0; i < num_threads; i++) {
+        workers[i].sh = &sh;
+        workers[i].index = i;
+        pthread_create(&threads[i], NULL, stress_main, &workers[i]);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    for (int i = 0; i < num_threads * STRESS_OPERATIONS; i++) {
+        assert(atomic_load(&sh.popped[i]) == 1);
+    }
+    assert(empty(&s));
+    // cell が 1 つも失われていないことを確認します。
+    int num_free = 0;
+    uint32_t index;
+    while (pop_cell(&s.free_cells, s.cells, &index)) {
+        num_free++;
+    }
+    assert(num_free == CAPACITY);
+
+    free(sh.popped);
+    destroy(&s);
+    return atomic_load(&sh.eliminated);
+}
+
+// NUM_OPERATIONS / num_threads 回ずつ push と pop の組を行います。
+// 共有の free list として使う場合を想定しています。
+void* benchmark_main(void* arg) {
+    worker* w = (worker*)arg;
+    shared* sh = w->sh;
+    exchanger_state = 88172645463325252ull * (w->index + 1) + 1;
+    num_eliminated = 0;
+    for (int i = 0; i < NUM_OPERATIONS / sh->num_threads; i++) {
+        if (sh->s == NULL) {
+            locked_push(sh->ls, i);
+            locked_pop(sh->ls);
+        } else {
+            push(sh->s, i);
+            pop(sh->s);
+        }
+    }
+    atomic_fetch_add(&sh->eliminated, num_eliminated);
+    return NULL;
+}
+
+// 1 秒あたりの push と pop の組の数を返します。
+double throughput(int num_threads, bool locked, bool elimination, long long* eliminated) {
+    stack s;
+    init(&s, CAPACITY, elimination);
+    locked_stack ls = {NULL, PTHREAD_MUTEX_INITIALIZER};
+    shared sh = {locked ? NULL : &s, &ls, num_threads, NULL, 0};
+
+    pthread_t threads[MAX_THREADS];
+    worker workers[MAX_THREADS];
+    double start = now();
+    for (int i = 0; i < num_threads; i++) {
+        workers[i].sh = &sh;
+        workers[i].index = i;
+        pthread_create(&threads[i], NULL, benchmark_main, &workers[i]);
+    }
+    for (int i = 0; i < num_threads; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double elapsed = now() - start;
+
+    assert(empty(&s) && ls.head == NULL);
+    destroy(&s);
+    if (eliminated != NULL) {
+        *eliminated = atomic_load(&sh.eliminated);
+    }
+    return NUM_OPERATIONS / elapsed;
+}
+
+int main() {
+    // stack_list.c と同じ操作を 1 つのスレッドで確認します。
+    stack s;
+    init(&s, 16, true);
+    for (int i = 0; i < 10; i++) {
+        push(&s, i);
+    }
+    print(&s);
+
+    printf("POP: %d\n", pop(&s));
+    print(&s);
+    destroy(&s);
+
+    printf("\nstress test\n");
+    for (int num_threads = 1; num_threads <= MAX_THREADS; num_threads *= 2) {
+        long long without = stress(num_threads, false);
+        long long with = stress(num_threads, true);
+        assert(without == 0);
+        printf("threads = %d: OK (eliminated %lld of %d pairs)\n", num_threads, with,
+               num_threads * STRESS_OPERATIONS);
+    }
+
+    printf("\n%7s %16s %16s %16s %12s\n", "threads", "locked list/s", "treiber/s", "elimination/s", "eliminated");
+    for (int num_threads = 1; num_threads <= MAX_THREADS; num_threads *= 2) {
+        long long eliminated;
+        double locked = throughput(num_threads, true, false, NULL);
+        double treiber = throughput(num_threads, false, false, NULL);
+        double elimination = throughput(num_threads, false, true, &eliminated);
+        printf("%7d %16.0lf %16.0lf %16.0lf %11.2lf%%\n", num_threads, locked, treiber, elimination,
+               100.0 * eliminated / NUM_OPERATIONS);
+    }
+
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// CPU が 1 コアの環境で実行したため CAS の競合がほとんど起きず、elimination は使われていません。
+// LIST: [ 9 8 7 6 5 4 3 2 1 0 ]
+// POP: 9
+// LIST: [ 8 7 6 5 4 3 2 1 0 ]
+//
+// stress test
+// threads = 1: OK (eliminated 0 of 65536 pairs)
+// threads = 2: OK (eliminated 0 of 131072 pairs)
+// threads = 4: OK (eliminated 0 of 262144 pairs)
+// threads = 8: OK (eliminated 0 of 524288 pairs)
+//
+// threads    locked list/s        treiber/s    elimination/s   eliminated
+//       1         17360557         19345470         20152322        0.00%
+//       2         17418651         21306661         24301823        0.00%
+//       4         20340411         24298705         23660185        0.00%
+//       8         21159569         23985896         22043170        0.00%
@@ -4,11 +4,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "string_arena.h"
+
 #define MAX_NUM_RECORDS 1000
 
+// value の文字列は values に置き、record には string_ref だけを持たせます (string_arena.h)。
+string_arena values;
+
 typedef struct {
     int key;
-    char value[32];
+    string_ref value;
 } record;
 
 typedef struct {
@@ -31,10 +36,11 @@ void insert(table* tab, int key, const char* value) {
     assert(tab->length < MAX_NUM_RECORDS - 1);
 
     tab->records[tab->length].key = key;
-    strcpy(tab->records[tab->length].value, value);
+    tab->records[tab->length].value = arena_store(&values, value);
     tab->length++;
 }
 
+// value の文字列は arena に残り、最後の arena_clear でまとめて解放されます。
 void erase(table* tab, int pos) {
     for (int i = pos; i < tab->length - 1; i++) {
         tab->records[i] = tab->records[i + 1];
@@ -46,8 +52,8 @@ void cli_insert(table* tab) {
     printf("Type in a key (>= 0) and a field. (example: \"100 XXX\")\n");
     while (true) {
         int key;
-        char value[32];
-        scanf("%d %s", &key, value);
+        char value[256];
+        scanf("%d %255s", &key, value);
         if (search(tab, key) != -1) {
             printf("The key is already used.\n");
         } else {
@@ -60,7 +66,8 @@ void cli_insert(table* tab) {
 void print(table* tab) {
     printf("TABLE: [ ");
     for (int i = 0; i < tab->length; i++) {
-        printf("{%d, %s} ", tab->records[i].key, tab->records[i].value);
+        record* rec = &tab->records[i];
+        printf("{%d, %.*s} ", rec->key, (int)rec->value.length, string_data(&values, &rec->value));
     }
     printf("]\n");
 }
@@ -83,7 +90,8 @@ int main() {
     int target = 3;
     int index = search(&tab, target);
     if (index != -1) {
-        printf("%d was %s\n", target, tab.records[index].value);
+        string_ref* value = &tab.records[index].value;
+        printf("%d was %.*s\n", target, (int)value->length, string_data(&values, value));
     } else {
         printf("%d was NOT FOUND\n", target);
     }
@@ -95,11 +103,13 @@ int main() {
     // search 3
     index = search(&tab, target);
     if (index != -1) {
-        printf("%d was %s\n", target, tab.records[index].value);
+        string_ref* value = &tab.records[index].value;
+        printf("%d was %.*s\n", target, (int)value->length, string_data(&values, value));
     } else {
         printf("%d was NOT FOUND\n", target);
     }
 
+    arena_clear(&values);
     return 0;
 }
 
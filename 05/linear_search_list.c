@@ -3,22 +3,40 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../03/pool_allocator.h"
+#include "string_arena.h"
+
+// value の文字列は values に置き、record には string_ref だけを持たせます (string_arena.h)。
+string_arena values;
+
 typedef struct record_ {
     int key;
-    char value[32];
+    string_ref value;
     struct record_* next;
 } record;
 
+// record は malloc ではなく、record と同じ大きさのオブジェクトだけを扱うプールから確保します。
+// 解放した record はプールに戻り、次の new_record で使い回されます (03/pool_allocator.h)。
+pool record_pool;
+
+record* new_record() {
+    return (record*)pool_alloc(&record_pool);
+}
+
+void delete_record(record* rec) {
+    pool_free(&record_pool, rec);
+}
+
 typedef struct {
     record* header;
     record* sentinel;
 } table;
 
 record* init_record(int key, const char* value) {
-    record* rec = (record*)malloc(sizeof(record));
+    record* rec = new_record();
     rec->next = NULL;
     rec->key = key;
-    strcpy(rec->value, value);
+    rec->value = arena_store(&values, value);
     return rec;
 }
 
@@ -26,12 +44,12 @@ void clear(table* tab) {
     record* current = tab->header->next;
     while (current != tab->sentinel) {
         record* next = current->next;
-        free(current);
+        delete_record(current);
         current = next;
     }
 
-    free(tab->header);
-    free(tab->sentinel);
+    delete_record(tab->header);
+    delete_record(tab->sentinel);
     tab->header = NULL;
     tab->sentinel = NULL;
 }
@@ -62,19 +80,20 @@ void insert_head(table* tab, record* rec) {
 void erase_next(record* previous) {
     record* current = previous->next;
     previous->next = current->next;
-    free(current);
+    delete_record(current);
 }
 
 void cli_insert_head(table* tab) {
     printf("Type in a key (>= 0) and a field. (example: \"100 XX\")\n");
     while (true) {
-        record* rec = init_record(-1, "");
-        scanf("%d %s", &rec->key, rec->value);
+        int key;
+        char value[256];
+        scanf("%d %255s", &key, value);
 
-        if (search_previous(tab, rec->key) != NULL) {
+        if (search_previous(tab, key) != NULL) {
             printf("The key is already used.\n");
         } else {
-            insert_head(tab, rec);
+            insert_head(tab, init_record(key, value));
             return;
         }
     }
@@ -84,7 +103,7 @@ void print(table* tab) {
     printf("TABLE: [ ");
     record* current = tab->header->next;
     while (current != tab->sentinel) {
-        printf("{%d, %s} ", current->key, current->value);
+        printf("{%d, %.*s} ", current->key, (int)current->value.length, string_data(&values, &current->value));
         current = current->next;
     }
     printf("]\n");
@@ -92,6 +111,7 @@ void print(table* tab) {
 
 int main() {
     // create table
+    pool_init(&record_pool, sizeof(record), OBJECTS_PER_SLAB);
     table tab;
     tab.sentinel = init_record(-1, "");
     tab.header = init_record(-1, "");
@@ -112,7 +132,8 @@ int main() {
     int target = 3;
     record* previous = search_previous(&tab, target);
     if (previous != NULL) {
-        printf("%d was %s\n", target, previous->next->value);
+        string_ref* value = &previous->next->value;
+        printf("%d was %.*s\n", target, (int)value->length, string_data(&values, value));
     } else {
         printf("%d was NOT FOUND\n", target);
     }
@@ -124,12 +145,15 @@ int main() {
     // search 3
     previous = search_previous(&tab, target);
     if (previous != NULL) {
-        printf("%d was %s\n", target, previous->next->value);
+        string_ref* value = &previous->next->value;
+        printf("%d was %.*s\n", target, (int)value->length, string_data(&values, value));
     } else {
         printf("%d was NOT FOUND\n", target);
     }
 
     clear(&tab);
+    pool_destroy(&record_pool);
+    arena_clear(&values);
     return 0;
 }
 
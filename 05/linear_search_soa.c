@@ -0,0 +1,334 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAS_X86_SIMD 1
+#else
+#define HAS_X86_SIMD 0
+#endif
+
+// 時間計測をする際には大きな数値にしてください。
+#define MIN_NUM_RECORDS 1000
+#define MAX_NUM_RECORDS 10000000
+// 1 つの大きさで、探索で比較するキーの数の合計がおおよそこの数になるように探します。
+#define NUM_SCANNED_KEYS 400000000LL
+
+#define CACHE_LINE 64
+
+// string_ref に書き換える前の linear_search_array.c の表は key (4 バイト) と value (32 バイト) を交互に並べているので、
+// key だけを比べていく search でも、読み込むキャッシュラインのうち 4 / 36 しか使いません。
+// ここでは key だけを連続した配列 (keys) に、value を別の配列 (values) に置きます (struct of arrays)。
+// 探索で読むのは keys だけになり、メモリから読む量はおおよそ 1/9 になります。
+// また keys は int が隙間なく並ぶので、SIMD 命令でまとめて比較できます。
+
+// string_ref に書き換える前の linear_search_array.c の table を、大きさを実行時に決められるようにしたものです。
+// search, insert, erase は linear_search_array.c のものと同じです。
+typedef struct {
+    int key;
+    char value[32];
+} record;
+
+typedef struct {
+    int length;
+    int capacity;
+    record* records;
+} table;
+
+void init(table* tab, int capacity) {
+    tab->length = 0;
+    tab->capacity = capacity;
+    tab->records = (record*)malloc((size_t)capacity * sizeof(record));
+}
+
+void clear(table* tab) {
+    free(tab->records);
+    tab->records = NULL;
+}
+
+int search(table* tab, int target) {
+    tab->records[tab->length].key = target;  // sentinel
+    int index = 0;
+    while (target != tab->records[index].key) {
+        index++;
+    }
+    return index < tab->length ? index : -1;
+}
+
+void insert(table* tab, int key, const char* value) {
+    assert(tab->length < tab->capacity - 1);
+
+    tab->records[tab->length].key = key;
+    strcpy(tab->records[tab->length].value, value);
+    tab->length++;
+}
+
+void erase(table* tab, int pos) {
+    for (int i = pos; i < tab->length - 1; i++) {
+        tab->records[i] = tab->records[i + 1];
+    }
+    tab->length--;
+}
+
+// key と value を別の配列に置いた表です。
+// keys は CACHE_LINE にそろえて確保し、長さも CACHE_LINE の倍数にします。
+// sentinel を置く分の 1 個も含めて、keys の最後のキャッシュラインまでは読んでもよいので、
+// SIMD 版は表の終わりを気にせずキャッシュライン単位で比較できます。
+typedef struct {
+    int length;
+    int capacity;
+    int* keys;
+    char (*values)[32];
+} soa_table;
+
+#define KEYS_PER_LINE (CACHE_LINE / (int)sizeof(int))
+
+void soa_init(soa_table* tab, int capacity) {
+    tab->length = 0;
+    tab->capacity = capacity;
+    size_t num_keys = ((size_t)capacity + KEYS_PER_LINE - 1) / KEYS_PER_LINE * KEYS_PER_LINE;
+    tab->keys = (int*)aligned_alloc(CACHE_LINE, num_keys * sizeof(int));
+    tab->values = (char(*)[32])malloc((size_t)capacity * sizeof(tab->values[0]));
+}
+
+void soa_clear(soa_table* tab) {
+    free(tab->keys);
+    free(tab->values);
+    tab->keys = NULL;
+    tab->values = NULL;
+}
+
+// search と同じく sentinel を置いて、keys だけを 1 個ずつ比べます。
+int soa_search_scalar(soa_table* tab, int target) {
+    int* keys = tab->keys;
+    keys[tab->length] = target;  // sentinel
+    int index = 0;
+    while (target != keys[index]) {
+        index++;
+    }
+    return index < tab->length ? index : -1;
+}
+
+#if HAS_X86_SIMD
+// SSE2 版です。1 回のループで 1 キャッシュライン (16 個) のキーを比較します。
+// sentinel があるので必ずどこかで一致し、ループの中で表の終わりを調べる必要はありません。
+int soa_search_sse2(soa_table* tab, int target) {
+    int* keys = tab->keys;
+    keys[tab->length] = target;  // sentinel
+    __m128i key = _mm_set1_epi32(target);
+    for (int i = 0;; i += KEYS_PER_LINE) {
+        __m128i a = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)(keys + i)), key);
+        __m128i b = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)(keys + i + 4)), key);
+        __m128i c = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)(keys + i + 8)), key);
+        __m128i d = _mm_cmpeq_epi32(_mm_load_si128((const __m128i*)(keys + i + 12)), key);
+        __m128i ab = _mm_packs_epi32(a, b);
+        __m128i cd = _mm_packs_epi32(c, d);
+        int mask = _mm_movemask_epi8(_mm_packs_epi16(ab, cd));
+        if (mask != 0) {
+            int index = i + __builtin_ctz(mask);
+            return index < tab->length ? index : -1;
+        }
+    }
+}
+
+// AVX2 版です。1 命令で 8 個、1 回のループで 1 キャッシュライン (16 個) のキーを比較します。
+__attribute__((target("avx2"))) int soa_search_avx2(soa_table* tab, int target) {
+    int* keys = tab->keys;
+    keys[tab->length] = target;  // sentinel
+    __m256i key = _mm256_set1_epi32(target);
+    for (int i = 0;; i += KEYS_PER_LINE) {
+        __m256i a = _mm256_cmpeq_epi32(_mm256_load_si256((const __m256i*)(keys + i)), key);
+        __m256i b = _mm256_cmpeq_epi32(_mm256_load_si256((const __m256i*)(keys + i + 8)), key);
+        __m256i any = _mm256_or_si256(a, b);
+        if (!_mm256_testz_si256(any, any)) {
+            unsigned mask = (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(a)) |
+                            (unsigned)_mm256_movemask_ps(_mm256_castsi256_ps(b)) << 8;
+            int index = i + __builtin_ctz(mask);
+            return index < tab->length ? index : -1;
+        }
+    }
+}
+#endif
+
+// 実行時に CPUID で CPU が対応している命令を調べて、使う関数を選びます。
+// 選ばれた関数は soa_search から呼び出せます。
+int (*soa_search)(soa_table* tab, int target) = soa_search_scalar;
+const char* soa_search_name = "scalar";
+
+void init_soa_search() {
+#if HAS_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        soa_search = soa_search_avx2;
+        soa_search_name = "avx2";
+        return;
+    }
+    soa_search = soa_search_sse2;
+    soa_search_name = "sse2";
+    return;
+#endif
+    soa_search = soa_search_scalar;
+    soa_search_name = "scalar";
+}
+
+void soa_insert(soa_table* tab, int key, const char* value) {
+    assert(tab->length < tab->capacity - 1);
+
+    tab->keys[tab->length] = key;
+    strcpy(tab->values[tab->length], value);
+    tab->length++;
+}
+
+void soa_erase(soa_table* tab, int pos) {
+    int num_moved = tab->length - 1 - pos;
+    memmove(&tab->keys[pos], &tab->keys[pos + 1], num_moved * sizeof(int));
+    memmove(&tab->values[pos], &tab->values[pos + 1], num_moved * sizeof(tab->values[0]));
+    tab->length--;
+}
+
+void soa_print(soa_table* tab) {
+    printf("TABLE: [ ");
+    for (int i = 0; i < tab->length; i++) {
+        printf("{%d, %s} ", tab->keys[i], tab->values[i]);
+    }
+    printf("]\n");
+}
+
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// 探索 1 回あたりの時間 (ns) を返します。見つかった index の合計を checksum に足します。
+double time_search(table* tab, int* targets, int num_queries, long long* checksum) {
+    double start = now();
+    for (int q = 0; q < num_queries; q++) {
+        *checksum += search(tab, targets[q]);
+    }
+    return (now() - start) * 1e9 / num_queries;
+}
+
+double time_soa_search(int (*f)(soa_table*, int), soa_table* tab, int* targets, int num_queries,
+                       long long* checksum) {
+    double start = now();
+    for (int q = 0; q < num_queries; q++) {
+        *checksum += f(tab, targets[q]);
+    }
+    return (now() - start) * 1e9 / num_queries;
+}
+
+int main() {
+    init_soa_search();
+    printf("selected kernel: %s\n", soa_search_name);
+
+    // linear_search_array.c の main と同じ操作をします。
+    soa_table small;
+    soa_init(&small, 1000);
+    soa_insert(&small, 5, "EEE");
+    soa_insert(&small, 2, "BBB");
+    soa_insert(&small, 1, "AAA");
+    soa_insert(&small, 3, "CCC");
+    soa_insert(&small, 4, "DDD");
+    soa_insert(&small, 100, "XXX");
+    soa_print(&small);
+    int target = 3;
+    int index = soa_search(&small, target);
+    if (index != -1) {
+        printf("%d was %s\n", target, small.values[index]);
+    } else {
+        printf("%d was NOT FOUND\n", target);
+    }
+    soa_erase(&small, index);
+    soa_print(&small);
+    index = soa_search(&small, target);
+    if (index != -1) {
+        printf("%d was %s\n", target, small.values[index]);
+    } else {
+        printf("%d was NOT FOUND\n", target);
+    }
+    soa_clear(&small);
+
+    // キー 0, 1, ..., n - 1 をランダムな順番で入れ、表に含まれるキーをランダムに探します。
+    // 平均で表の半分を読むことになります。
+    int* keys = (int*)malloc(MAX_NUM_RECORDS * sizeof(int));
+    uint64_t state = 88172645463325252ULL;
+    printf("\nsizeof(record) = %zu, bytes read per key: table %zu, soa_table %zu\n", sizeof(record),
+           sizeof(record), sizeof(int));
+    printf("%10s %12s %12s %12s %10s %10s\n", "records", "table ns", "soa scalar", "soa simd", "GB/s tab",
+           "GB/s soa");
+    for (int n = MIN_NUM_RECORDS; n <= MAX_NUM_RECORDS; n *= 10) {
+        for (int i = 0; i < n; i++) {
+            keys[i] = i;
+        }
+        for (int i = n - 1; i > 0; i--) {
+            int j = (int)(xorshift64(&state) % (uint64_t)(i + 1));
+            int tmp = keys[i];
+            keys[i] = keys[j];
+            keys[j] = tmp;
+        }
+
+        table tab;
+        soa_table soa;
+        init(&tab, n + 1);
+        soa_init(&soa, n + 1);
+        for (int i = 0; i < n; i++) {
+            insert(&tab, keys[i], "AAA");
+            soa_insert(&soa, keys[i], "AAA");
+        }
+
+        int num_queries = (int)(NUM_SCANNED_KEYS * 2 / n);
+        int* targets = (int*)malloc(num_queries * sizeof(int));
+        for (int q = 0; q < num_queries; q++) {
+            targets[q] = (int)(xorshift64(&state) % (uint64_t)n);
+        }
+
+        long long checksums[3] = {0};
+        double t_table = time_search(&tab, targets, num_queries, &checksums[0]);
+        double t_scalar = time_soa_search(soa_search_scalar, &soa, targets, num_queries, &checksums[1]);
+        double t_simd = time_soa_search(soa_search, &soa, targets, num_queries, &checksums[2]);
+        assert(checksums[0] == checksums[1] && checksums[1] == checksums[2]);
+
+        // 1 回の探索では平均で n / 2 個のキーを読みます。
+        double gbps_table = n / 2.0 * sizeof(record) / t_table;
+        double gbps_soa = n / 2.0 * sizeof(int) / t_simd;
+        printf("%10d %12.1lf %12.1lf %12.1lf %10.1lf %10.1lf\n", n, t_table, t_scalar, t_simd, gbps_table,
+               gbps_soa);
+
+        free(targets);
+        clear(&tab);
+        soa_clear(&soa);
+    }
+
+    free(keys);
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// selected kernel: avx2
+// TABLE: [ {5, EEE} {2, BBB} {1, AAA} {3, CCC} {4, DDD} {100, XXX} ]
+// 3 was CCC
+// TABLE: [ {5, EEE} {2, BBB} {1, AAA} {4, DDD} {100, XXX} ]
+// 3 was NOT FOUND
+//
+// sizeof(record) = 36, bytes read per key: table 36, soa_table 4
+//    records     table ns   soa scalar     soa simd   GB/s tab   GB/s soa
+//       1000        684.0        368.7         66.4       26.3       30.1
+//      10000       6878.7       2774.2        421.7       26.2       47.4
+//     100000      83664.7      37156.8       5320.4       21.5       37.6
+//    1000000    1102287.2     409710.4      91114.4       16.3       22.0
+//   10000000   20709026.1    3728015.7    1354338.0        8.7       14.8
@@ -0,0 +1,387 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "string_arena.h"
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_RECORDS 1000
+#define NUM_LOOKUPS 1000000
+
+// 線形探索の表で、見つかった record を前の方に移していく (自己再構成) 方法です。
+// よく探されるキーほど前に集まるので、キーの人気に偏りがあると比較の回数が減ります。
+// MOVE_TO_FRONT: 見つかった record を先頭に移す。
+//                linear_search_list.c の search_previous でコメントアウトされている方法です。
+// TRANSPOSE:     見つかった record を 1 つ前と入れ替える。ゆっくりとしか動きませんが、
+//                たまにしか探されないキーが先頭に来てしまうことがありません。
+// COUNT:         record ごとに探された回数を数え、回数の多い順に並ぶように移す。
+//                回数を覚えておく領域が必要で、人気が変わったときの追従が遅くなります。
+typedef enum { NONE, MOVE_TO_FRONT, TRANSPOSE, COUNT } policy;
+
+const char* policy_names[] = {"none", "move-to-front", "transpose", "count"};
+
+// 探索で比較した record の数の合計です。
+long long num_probes = 0;
+
+// value の文字列を置く arena です (string_arena.h)。
+string_arena values;
+
+// linear_search_list.c の表に、探された回数 (count) を加えたものです。
+typedef struct record_ {
+    int key;
+    int count;
+    string_ref value;
+    struct record_* next;
+} record;
+
+typedef struct {
+    record* header;
+    record* sentinel;
+} table;
+
+record* init_record(int key, const char* value) {
+    record* rec = (record*)malloc(sizeof(record));
+    rec->next = NULL;
+    rec->key = key;
+    rec->count = 0;
+    rec->value = arena_store(&values, value);
+    return rec;
+}
+
+void init(table* tab) {
+    tab->sentinel = init_record(-1, "");
+    tab->header = init_record(-1, "");
+    tab->header->next = tab->sentinel;
+}
+
+void clear(table* tab) {
+    record* current = tab->header->next;
+    while (current != tab->sentinel) {
+        record* next = current->next;
+        free(current);
+        current = next;
+    }
+
+    free(tab->header);
+    free(tab->sentinel);
+    tab->header = NULL;
+    tab->sentinel = NULL;
+}
+
+void insert_head(table* tab, record* rec) {
+    rec->next = tab->header->next;
+    tab->header->next = rec;
+}
+
+// linear_search_list.c の search_previous に policy を加えたものです。
+// 見つかった record は policy に従って移され、移した後の 1 つ前の record を返します。
+record* search_previous(table* tab, int target, policy p) {
+    tab->sentinel->key = target;
+    record* before_previous = NULL;
+    record* previous = tab->header;
+    record* current = tab->header->next;
+    int steps = 1;
+    while (target != current->key) {
+        before_previous = previous;
+        previous = current;
+        current = current->next;
+        steps++;
+    }
+    num_probes += steps;
+    if (current == tab->sentinel) {
+        return NULL;
+    }
+
+    switch (p) {
+    case MOVE_TO_FRONT:
+        previous->next = current->next;
+        insert_head(tab, current);
+        return tab->header;
+    case TRANSPOSE:
+        if (before_previous == NULL) {
+            return previous;
+        }
+        // before_previous -> previous -> current を before_previous -> current -> previous にします。
+        previous->next = current->next;
+        current->next = previous;
+        before_previous->next = current;
+        return before_previous;
+    case COUNT: {
+        current->count++;
+        // current より前の record の count は、増やす前の current->count 以上です。
+        // 増やした後の count より小さい最初の record の前に移します。
+        record* position = tab->header;
+        while (position->next != current && position->next->count >= current->count) {
+            position = position->next;
+        }
+        if (position->next == current) {
+            return previous;
+        }
+        previous->next = current->next;
+        current->next = position->next;
+        position->next = current;
+        return position;
+    }
+    default:
+        return previous;
+    }
+}
+
+// linear_search_array.c の表に、探された回数 (count) を加えたものです。
+typedef struct {
+    int key;
+    int count;
+    string_ref value;
+} array_record;
+
+typedef struct {
+    int length;
+    array_record records[NUM_RECORDS + 1];
+} array_table;
+
+void array_insert(array_table* tab, int key, const char* value) {
+    assert(tab->length < NUM_RECORDS);
+
+    tab->records[tab->length].key = key;
+    tab->records[tab->length].count = 0;
+    tab->records[tab->length].value = arena_store(&values, value);
+    tab->length++;
+}
+
+// linear_search_array.c の search に policy を加えたものです。
+// 見つかった record は policy に従って移され、移した後の index を返します。
+// 配列では record を移すと間の record をずらす必要があるので、
+// MOVE_TO_FRONT と COUNT は見つかった位置に比例する時間がかかります。
+int array_search(array_table* tab, int target, policy p) {
+    tab->records[tab->length].key = target;  // sentinel
+    int index = 0;
+    while (target != tab->records[index].key) {
+        index++;
+    }
+    num_probes += index + 1;
+    if (index == tab->length) {
+        return -1;
+    }
+
+    array_record found = tab->records[index];
+    int destination = index;
+    switch (p) {
+    case MOVE_TO_FRONT:
+        destination = 0;
+        break;
+    case TRANSPOSE:
+        destination = index > 0 ? index - 1 : 0;
+        break;
+    case COUNT:
+        found.count++;
+        while (destination > 0 && tab->records[destination - 1].count < found.count) {
+            destination--;
+        }
+        break;
+    default:
+        return index;
+    }
+    memmove(&tab->records[destination + 1], &tab->records[destination],
+            (index - destination) * sizeof(array_record));
+    tab->records[destination] = found;
+    return destination;
+}
+
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+// libm をリンクしなくてよいように、平方根は Newton 法で求めます。
+double square_root(double x) {
+    double y = x > 1 ? x : 1;
+    for (int i = 0; i < 64; i++) {
+        double next = (y + x / y) / 2;
+        if (next >= y) {
+            break;
+        }
+        y = next;
+    }
+    return y;
+}
+
+// 人気が rank 番目 (1 から数える) のキーの重み 1 / rank^s です。
+// s は 0.5 刻みとし、s = half_s / 2 で指定します。
+double zipf_weight(int rank, int half_s) {
+    double w = 1.0;
+    for (int i = 0; i < half_s / 2; i++) {
+        w /= rank;
+    }
+    if (half_s % 2 == 1) {
+        w /= square_root(rank);
+    }
+    return w;
+}
+
+// Zipf 分布に従って NUM_RECORDS 個のキーから length 個を選びます。
+// 人気の順番とキーの値 (表の中の最初の位置) は無関係にするため、ランダムに対応させます。
+// 人気の順に並べた場合の平均の比較回数 (最適な固定の並び) を返します。
+double make_zipf_queries(int* queries, int length, int half_s, uint64_t* state) {
+    int keys[NUM_RECORDS];
+    double cdf[NUM_RECORDS];
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        keys[i] = i;
+    }
+    for (int i = NUM_RECORDS - 1; i > 0; i--) {
+        int j = (int)(xorshift64(state) % (uint64_t)(i + 1));
+        int tmp = keys[i];
+        keys[i] = keys[j];
+        keys[j] = tmp;
+    }
+    double total = 0;
+    double optimal = 0;
+    for (int i = 0; i < NUM_RECORDS; i++) {
+        double w = zipf_weight(i + 1, half_s);
+        total += w;
+        optimal += w * (i + 1);
+        cdf[i] = total;
+    }
+
+    for (int q = 0; q < length; q++) {
+        double u = (double)(xorshift64(state) >> 11) / (double)(1ULL << 53) * total;
+        // cdf[i] > u となる最小の i を二分探索で求めます。
+        int low = 0;
+        int high = NUM_RECORDS - 1;
+        while (low < high) {
+            int middle = (low + high) / 2;
+            if (cdf[middle] > u) {
+                high = middle;
+            } else {
+                low = middle + 1;
+            }
+        }
+        queries[q] = keys[low];
+    }
+    return optimal / total;
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    double probes;
+    double ns;
+} result;
+
+// キーが 0, 1, 2, ... の順に並んだ表から始めて、queries を順に探します。
+result benchmark_list(int* queries, policy p) {
+    table tab;
+    init(&tab);
+    for (int key = NUM_RECORDS - 1; key >= 0; key--) {
+        insert_head(&tab, init_record(key, "AAA"));
+    }
+
+    num_probes = 0;
+    double start = now();
+    for (int q = 0; q < NUM_LOOKUPS; q++) {
+        record* previous = search_previous(&tab, queries[q], p);
+        assert(previous != NULL && previous->next->key == queries[q]);
+    }
+    result r = {(double)num_probes / NUM_LOOKUPS, (now() - start) * 1e9 / NUM_LOOKUPS};
+    clear(&tab);
+    return r;
+}
+
+result benchmark_array(int* queries, policy p) {
+    array_table* tab = (array_table*)malloc(sizeof(array_table));
+    tab->length = 0;
+    for (int key = 0; key < NUM_RECORDS; key++) {
+        array_insert(tab, key, "AAA");
+    }
+
+    num_probes = 0;
+    double start = now();
+    for (int q = 0; q < NUM_LOOKUPS; q++) {
+        int index = array_search(tab, queries[q], p);
+        assert(index != -1 && tab->records[index].key == queries[q]);
+    }
+    result r = {(double)num_probes / NUM_LOOKUPS, (now() - start) * 1e9 / NUM_LOOKUPS};
+    free(tab);
+    return r;
+}
+
+int main() {
+    // 小さな表で、同じ順番で探したときの並びの変化を確認します。
+    int targets[] = {4, 4, 2, 4, 1, 2, 4};
+    for (policy p = MOVE_TO_FRONT; p <= COUNT; p++) {
+        table tab;
+        init(&tab);
+        for (int key = 5; key >= 1; key--) {
+            insert_head(&tab, init_record(key, "AAA"));
+        }
+        for (int i = 0; i < 7; i++) {
+            search_previous(&tab, targets[i], p);
+        }
+        printf("%-14s LIST: [ ", policy_names[p]);
+        for (record* current = tab.header->next; current != tab.sentinel; current = current->next) {
+            printf("%d ", current->key);
+        }
+        printf("]\n");
+        clear(&tab);
+    }
+
+    int* queries = (int*)malloc(NUM_LOOKUPS * sizeof(int));
+    uint64_t state = 88172645463325252ULL;
+    printf("\nNUM_RECORDS = %d, NUM_LOOKUPS = %d\n", NUM_RECORDS, NUM_LOOKUPS);
+    printf("%-4s %-14s %12s %10s %12s %10s\n", "s", "policy", "list probes", "list ns", "array probes",
+           "array ns");
+    for (int half_s = 0; half_s <= 3; half_s++) {
+        double optimal = make_zipf_queries(queries, NUM_LOOKUPS, half_s, &state);
+        for (policy p = NONE; p <= COUNT; p++) {
+            result list = benchmark_list(queries, p);
+            result array = benchmark_array(queries, p);
+            printf("%-4.1lf %-14s %12.1lf %10.1lf %12.1lf %10.1lf\n", half_s / 2.0, policy_names[p], list.probes,
+                   list.ns, array.probes, array.ns);
+        }
+        printf("%-4.1lf %-14s %12.1lf\n", half_s / 2.0, "(optimal)", optimal);
+    }
+
+    free(queries);
+    arena_clear(&values);
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// 探索の回数が少ないうちは最初の並びの影響が残るので、表の並びが落ち着くまでの分も含めた平均です。
+// move-to-front  LIST: [ 4 2 1 3 5 ]
+// transpose      LIST: [ 1 4 2 3 5 ]
+// count          LIST: [ 4 2 1 3 5 ]
+//
+// NUM_RECORDS = 1000, NUM_LOOKUPS = 1000000
+// s    policy          list probes    list ns array probes   array ns
+// 0.0  none                  500.6      951.4        500.6      214.5
+// 0.0  move-to-front         500.6     1038.3        500.6      433.3
+// 0.0  transpose             500.6     1034.1        500.6      272.9
+// 0.0  count                 500.7     1943.4        500.7      260.1
+// 0.0  (optimal)             500.5
+// 0.5  none                  501.4      908.6        501.4      330.8
+// 0.5  move-to-front         418.7      817.3        418.7      256.6
+// 0.5  transpose             388.8      757.0        388.8      247.8
+// 0.5  count                 343.3     1340.7        343.3      192.6
+// 0.5  (optimal)             341.4
+// 1.0  none                  559.9     1034.9        559.9      315.2
+// 1.0  move-to-front         185.0      351.5        185.0      142.2
+// 1.0  transpose             176.1      320.2        176.1       89.9
+// 1.0  count                 134.8      514.6        134.8      109.4
+// 1.0  (optimal)             133.6
+// 1.5  none                  492.3      923.6        492.3      230.0
+// 1.5  move-to-front          36.0       74.5         36.0       33.4
+// 1.5  transpose              51.4      107.9         51.4       39.1
+// 1.5  count                  24.9      116.1         24.9       31.6
+// 1.5  (optimal)              24.2
@@ -0,0 +1,1498 @@
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "string_arena.h"
+
+// 時間計測をする際には大きな数値にしてください。
+#define NUM_TABLE_RECORDS 1000000
+#define NUM_TABLE_LOOKUPS 1000
+#define NUM_LIST_RECORDS 100000
+#define NUM_LIST_LOOKUPS 1000
+#define NUM_SORTED_RECORDS 1000000
+#define NUM_SORTED_LOOKUPS 1000000
+#define NUM_TREE_NODES 1000000
+#define NUM_TREE_LOOKUPS 1000000
+
+// 05 から 08 の辞書は、もともと value を char value[32] として record や node に埋め込み、
+// strcpy で書き込んでいました。短い value でも 32 バイトを使い、31 文字より長い value は入りません。
+// ここでは value の文字列を 1 つの大きな領域 (arena) に詰めて置き、record には
+// 文字列の位置と長さ (string_ref, 8 バイト) だけを持たせます。
+// 短い文字列は arena に置かず、string_ref の中に直接入れます。
+//
+// string_ref と arena は string_arena.h にあり、05/linear_search_array.c, 05/linear_search_list.c,
+// 06/binary_search.c, 06/binary_search_tree.c, 07/avl_tree.c, 08/b_tree.c もそれを include して
+// string_ref を使うように書き換えてあります。
+// このファイルでは 6 つの辞書それぞれについて、char value[32] 版と string_ref 版を比べます。
+
+// value をすべての辞書で共有する arena です。
+string_arena values;
+
+// 計測のために、record や node を確保するたびにその大きさを足していきます。
+size_t allocated_bytes = 0;
+
+// 05/linear_search_array.c の、string_ref に書き換える前の table を、大きさを実行時に決められるようにしたものです。
+typedef struct {
+    int key;
+    char value[32];
+} record;
+
+typedef struct {
+    int length;
+    int capacity;
+    record* records;
+} table;
+
+int search(table* tab, int target) {
+    tab->records[tab->length].key = target;  // sentinel
+    int index = 0;
+    while (target != tab->records[index].key) {
+        index++;
+    }
+    return index < tab->length ? index : -1;
+}
+
+void insert(table* tab, int key, const char* value) {
+    assert(tab->length < tab->capacity - 1);
+
+    tab->records[tab->length].key = key;
+    strcpy(tab->records[tab->length].value, value);
+    tab->length++;
+}
+
+// value を arena に置いた table です。search は table の search と同じです。
+typedef struct {
+    int key;
+    string_ref value;
+} arena_record;
+
+typedef struct {
+    int length;
+    int capacity;
+    arena_record* records;
+} arena_table;
+
+int arena_search(arena_table* tab, int target) {
+    tab->records[tab->length].key = target;  // sentinel
+    int index = 0;
+    while (target != tab->records[index].key) {
+        index++;
+    }
+    return index < tab->length ? index : -1;
+}
+
+void arena_insert(arena_table* tab, int key, const char* value) {
+    assert(tab->length < tab->capacity - 1);
+
+    tab->records[tab->length].key = key;
+    tab->records[tab->length].value = arena_store(&values, value);
+    tab->length++;
+}
+
+// 05/linear_search_list.c の、string_ref に書き換える前の record, table, init_record, clear, search_previous, insert_head です。
+// 名前がぶつかるものには list_ を付けています。
+typedef struct list_record_ {
+    int key;
+    char value[32];
+    struct list_record_* next;
+} list_record;
+
+typedef struct {
+    list_record* header;
+    list_record* sentinel;
+} list_table;
+
+list_record* init_list_record(int key, const char* value) {
+    list_record* rec = (list_record*)malloc(sizeof(list_record));
+    allocated_bytes += sizeof(list_record);
+    rec->next = NULL;
+    rec->key = key;
+    strcpy(rec->value, value);
+    return rec;
+}
+
+void list_clear(list_table* tab) {
+    list_record* current = tab->header->next;
+    while (current != tab->sentinel) {
+        list_record* next = current->next;
+        free(current);
+        current = next;
+    }
+
+    free(tab->header);
+    free(tab->sentinel);
+    tab->header = NULL;
+    tab->sentinel = NULL;
+}
+
+list_record* search_previous(list_table* tab, int target) {
+    tab->sentinel->key = target;
+    list_record* previous = tab->header;
+    list_record* current = tab->header->next;
+    while (target != current->key) {
+        previous = current;
+        current = current->next;
+    }
+    return current != tab->sentinel ? previous : NULL;
+}
+
+void insert_head(list_table* tab, list_record* rec) {
+    rec->next = tab->header->next;
+    tab->header->next = rec;
+}
+
+// value を arena に置いた list の record です。
+typedef struct arena_list_record_ {
+    int key;
+    string_ref value;
+    struct arena_list_record_* next;
+} arena_list_record;
+
+typedef struct {
+    arena_list_record* header;
+    arena_list_record* sentinel;
+} arena_list_table;
+
+arena_list_record* init_arena_list_record(int key, const char* value) {
+    arena_list_record* rec = (arena_list_record*)malloc(sizeof(arena_list_record));
+    allocated_bytes += sizeof(arena_list_record);
+    rec->next = NULL;
+    rec->key = key;
+    rec->value = arena_store(&values, value);
+    return rec;
+}
+
+void arena_list_clear(arena_list_table* tab) {
+    arena_list_record* current = tab->header->next;
+    while (current != tab->sentinel) {
+        arena_list_record* next = current->next;
+        free(current);
+        current = next;
+    }
+
+    free(tab->header);
+    free(tab->sentinel);
+    tab->header = NULL;
+    tab->sentinel = NULL;
+}
+
+arena_list_record* arena_search_previous(arena_list_table* tab, int target) {
+    tab->sentinel->key = target;
+    arena_list_record* previous = tab->header;
+    arena_list_record* current = tab->header->next;
+    while (target != current->key) {
+        previous = current;
+        current = current->next;
+    }
+    return current != tab->sentinel ? previous : NULL;
+}
+
+void arena_insert_head(arena_list_table* tab, arena_list_record* rec) {
+    rec->next = tab->header->next;
+    tab->header->next = rec;
+}
+
+// 06/binary_search.c の、string_ref に書き換える前の record, table, search, insert を、
+// 大きさを実行時に決められるようにしたものです。名前がぶつかるものには sorted_ を付けています。
+typedef struct {
+    int key;
+    char value[32];
+} sorted_record;
+
+typedef struct {
+    int length;
+    int capacity;
+    sorted_record* records;
+} sorted_table;
+
+// key 以下となる値が現れる最大の index を返します。
+// もし条件を満たす値が存在しない場合は -1 を返します。
+int sorted_search(sorted_table* tab, int target) {
+    int low = 0;
+    int high = tab->length - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (target < tab->records[middle].key) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return high;
+}
+
+void sorted_insert(sorted_table* tab, sorted_record rec) {
+    assert(tab->length < tab->capacity);
+
+    int index = sorted_search(tab, rec.key);
+    for (int i = tab->length; i > index + 1; i--) {
+        tab->records[i] = tab->records[i - 1];
+    }
+    tab->records[index + 1] = rec;
+    tab->length++;
+}
+
+// value を arena に置いた、06/binary_search.c の record と table です。
+typedef struct {
+    int key;
+    string_ref value;
+} arena_sorted_record;
+
+typedef struct {
+    int length;
+    int capacity;
+    arena_sorted_record* records;
+} arena_sorted_table;
+
+int arena_sorted_search(arena_sorted_table* tab, int target) {
+    int low = 0;
+    int high = tab->length - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (target < tab->records[middle].key) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return high;
+}
+
+void arena_sorted_insert(arena_sorted_table* tab, arena_sorted_record rec) {
+    assert(tab->length < tab->capacity);
+
+    int index = arena_sorted_search(tab, rec.key);
+    for (int i = tab->length; i > index + 1; i--) {
+        tab->records[i] = tab->records[i - 1];
+    }
+    tab->records[index + 1] = rec;
+    tab->length++;
+}
+
+// 06/binary_search_tree.c の、string_ref に書き換える前の node, init_node, clear, search, insert です。
+// search と insert は table のものと名前がぶつかるので、tree_search と tree_insert にしています。
+typedef struct node_ {
+    int key;
+    char value[32];
+    struct node_* left;
+    struct node_* right;
+} node;
+
+node* init_node(int key, const char* value) {
+    node* n = (node*)malloc(sizeof(node));
+    allocated_bytes += sizeof(node);
+    n->key = key;
+    n->left = NULL;
+    n->right = NULL;
+    strcpy(n->value, value);
+    return n;
+}
+
+void clear(node** p_current) {
+    node* current = *p_current;
+    if (current != NULL) {
+        clear(&current->left);
+        clear(&current->right);
+        free(current);
+        *p_current = NULL;
+    }
+}
+
+node* tree_search(node* current, int target) {
+    if (current == NULL) {
+        return NULL;
+    }
+
+    if (target == current->key) {
+        return current;
+    }
+
+    if (target < current->key) {
+        return tree_search(current->left, target);
+    } else {
+        return tree_search(current->right, target);
+    }
+}
+
+void tree_insert(node** p_current, int key, const char* value) {
+    node* current = *p_current;
+    if (current == NULL) {
+        *p_current = init_node(key, value);
+        return;
+    }
+
+    assert(key != current->key);
+
+    if (key < current->key) {
+        tree_insert(&current->left, key, value);
+    } else {
+        tree_insert(&current->right, key, value);
+    }
+}
+
+// value を arena に置いた node です。clear しても value は解放されないので、
+// arena_reset か arena_clear でまとめて解放します。
+typedef struct arena_node_ {
+    int key;
+    string_ref value;
+    struct arena_node_* left;
+    struct arena_node_* right;
+} arena_node;
+
+arena_node* init_arena_node(int key, const char* value) {
+    arena_node* n = (arena_node*)malloc(sizeof(arena_node));
+    allocated_bytes += sizeof(arena_node);
+    n->key = key;
+    n->left = NULL;
+    n->right = NULL;
+    n->value = arena_store(&values, value);
+    return n;
+}
+
+void arena_tree_clear(arena_node** p_current) {
+    arena_node* current = *p_current;
+    if (current != NULL) {
+        arena_tree_clear(&current->left);
+        arena_tree_clear(&current->right);
+        free(current);
+        *p_current = NULL;
+    }
+}
+
+arena_node* arena_tree_search(arena_node* current, int target) {
+    if (current == NULL) {
+        return NULL;
+    }
+
+    if (target == current->key) {
+        return current;
+    }
+
+    if (target < current->key) {
+        return arena_tree_search(current->left, target);
+    } else {
+        return arena_tree_search(current->right, target);
+    }
+}
+
+void arena_tree_insert(arena_node** p_current, int key, const char* value) {
+    arena_node* current = *p_current;
+    if (current == NULL) {
+        *p_current = init_arena_node(key, value);
+        return;
+    }
+
+    assert(key != current->key);
+
+    if (key < current->key) {
+        arena_tree_insert(&current->left, key, value);
+    } else {
+        arena_tree_insert(&current->right, key, value);
+    }
+}
+
+void arena_tree_print(arena_node* current, int depth) {
+    if (current == NULL) {
+        return;
+    }
+    arena_tree_print(current->right, depth + 1);
+    for (int i = 0; i < depth; i++) {
+        printf("  ");
+    }
+    printf("{%d, %.*s}\n", current->key, (int)current->value.length, string_data(&values, &current->value));
+    arena_tree_print(current->left, depth + 1);
+}
+
+// 07/avl_tree.c の、string_ref に書き換える前の direction, node, rebalance, insert です。
+// 名前がぶつかるものには avl_ を付けています。
+// 07/avl_tree.c には無い search と clear を加えています。
+typedef enum {
+    LEFT,
+    RIGHT,
+    BALANCED,
+} direction;
+
+typedef struct avl_node_ {
+    int key;
+    char value[32];
+    struct avl_node_* children[2];
+    direction balance;
+} avl_node;
+
+// 部分木が成長した場合は true を、そうでない場合は false を返す。
+bool avl_rebalance(avl_node** p, direction inserted_dir) {
+    direction opposite_dir;
+    if (inserted_dir == LEFT) {
+        opposite_dir = RIGHT;
+    } else {
+        opposite_dir = LEFT;
+    }
+
+    // case 1: 挿入された方向と逆の高さが1高い場合
+    avl_node* a = *p;
+    if (a->balance == opposite_dir) {
+        a->balance = BALANCED;
+        return false;
+    }
+
+    // case 2: 左右の高さが等しい場合
+    if (a->balance == BALANCED) {
+        a->balance = inserted_dir;
+        return true;
+    }
+
+    // case 3: 挿入された方向の高さが1高い場合
+    // case 3a: 1重回転
+    avl_node* b = a->children[inserted_dir];
+    if (b->balance == inserted_dir) {
+        a->children[inserted_dir] = b->children[opposite_dir];  // βをBからAに付け替え
+        b->children[opposite_dir] = a;                          // βの場所にAを入れる
+        a->balance = BALANCED;
+        b->balance = BALANCED;
+        *p = b;  // Bを上に持ち上げる
+        return false;
+    }
+
+    // case 3c: 2重回転
+    if (b->balance == opposite_dir) {
+        avl_node* c = b->children[opposite_dir];
+        b->children[opposite_dir] = c->children[inserted_dir];  // β1をCからBに付け替え
+        a->children[inserted_dir] = c->children[opposite_dir];  // β2をCからAに付け替え
+        c->children[inserted_dir] = b;                          // BをCに付け替え
+        c->children[opposite_dir] = a;                          // AをCに付け替え
+        if (c->balance != opposite_dir) {
+            b->balance = BALANCED;
+        } else {
+            b->balance = inserted_dir;
+        }
+        if (c->balance != inserted_dir) {
+            a->balance = BALANCED;
+        } else {
+            a->balance = opposite_dir;
+        }
+        c->balance = BALANCED;
+        *p = c;  // Cを上に持ち上げる
+        return false;
+    }
+
+    // case 3b (invalid)
+    assert(false);
+}
+
+// 部分木が成長した場合は true を、そうでない場合は false を返す。
+bool avl_insert(avl_node** p_current, int key, const char* value) {
+    avl_node* current = *p_current;
+
+    // リーフに達したら挿入
+    if (current == NULL) {
+        avl_node* n = (avl_node*)malloc(sizeof(avl_node));
+        allocated_bytes += sizeof(avl_node);
+        n->key = key;
+        n->children[LEFT] = NULL;
+        n->children[RIGHT] = NULL;
+        n->balance = BALANCED;
+        strcpy(n->value, value);
+        *p_current = n;
+        return true;
+    }
+
+    // キーが一致したらエラー
+    assert(key != current->key);
+
+    if (key < current->key) {
+        if (avl_insert(&current->children[LEFT], key, value)) {
+            return avl_rebalance(p_current, LEFT);
+        }
+    } else {
+        if (avl_insert(&current->children[RIGHT], key, value)) {
+            return avl_rebalance(p_current, RIGHT);
+        }
+    }
+    return false;
+}
+
+avl_node* avl_search(avl_node* current, int target) {
+    while (current != NULL && target != current->key) {
+        current = current->children[target < current->key ? LEFT : RIGHT];
+    }
+    return current;
+}
+
+void avl_clear(avl_node** p_current) {
+    avl_node* current = *p_current;
+    if (current != NULL) {
+        avl_clear(&current->children[LEFT]);
+        avl_clear(&current->children[RIGHT]);
+        free(current);
+        *p_current = NULL;
+    }
+}
+
+// value を arena に置いた AVL 木の node です。
+typedef struct arena_avl_node_ {
+    int key;
+    string_ref value;
+    struct arena_avl_node_* children[2];
+    direction balance;
+} arena_avl_node;
+
+// 部分木が成長した場合は true を、そうでない場合は false を返す。
+bool arena_avl_rebalance(arena_avl_node** p, direction inserted_dir) {
+    direction opposite_dir;
+    if (inserted_dir == LEFT) {
+        opposite_dir = RIGHT;
+    } else {
+        opposite_dir = LEFT;
+    }
+
+    // case 1: 挿入された方向と逆の高さが1高い場合
+    arena_avl_node* a = *p;
+    if (a->balance == opposite_dir) {
+        a->balance = BALANCED;
+        return false;
+    }
+
+    // case 2: 左右の高さが等しい場合
+    if (a->balance == BALANCED) {
+        a->balance = inserted_dir;
+        return true;
+    }
+
+    // case 3: 挿入された方向の高さが1高い場合
+    // case 3a: 1重回転
+    arena_avl_node* b = a->children[inserted_dir];
+    if (b->balance == inserted_dir) {
+        a->children[inserted_dir] = b->children[opposite_dir];  // βをBからAに付け替え
+        b->children[opposite_dir] = a;                          // βの場所にAを入れる
+        a->balance = BALANCED;
+        b->balance = BALANCED;
+        *p = b;  // Bを上に持ち上げる
+        return false;
+    }
+
+    // case 3c: 2重回転
+    if (b->balance == opposite_dir) {
+        arena_avl_node* c = b->children[opposite_dir];
+        b->children[opposite_dir] = c->children[inserted_dir];  // β1をCからBに付け替え
+        a->children[inserted_dir] = c->children[opposite_dir];  // β2をCからAに付け替え
+        c->children[inserted_dir] = b;                          // BをCに付け替え
+        c->children[opposite_dir] = a;                          // AをCに付け替え
+        if (c->balance != opposite_dir) {
+            b->balance = BALANCED;
+        } else {
+            b->balance = inserted_dir;
+        }
+        if (c->balance != inserted_dir) {
+            a->balance = BALANCED;
+        } else {
+            a->balance = opposite_dir;
+        }
+        c->balance = BALANCED;
+        *p = c;  // Cを上に持ち上げる
+        return false;
+    }
+
+    // case 3b (invalid)
+    assert(false);
+}
+
+// 部分木が成長した場合は true を、そうでない場合は false を返す。
+bool arena_avl_insert(arena_avl_node** p_current, int key, const char* value) {
+    arena_avl_node* current = *p_current;
+
+    // リーフに達したら挿入
+    if (current == NULL) {
+        arena_avl_node* n = (arena_avl_node*)malloc(sizeof(arena_avl_node));
+        allocated_bytes += sizeof(arena_avl_node);
+        n->key = key;
+        n->children[LEFT] = NULL;
+        n->children[RIGHT] = NULL;
+        n->balance = BALANCED;
+        n->value = arena_store(&values, value);
+        *p_current = n;
+        return true;
+    }
+
+    // キーが一致したらエラー
+    assert(key != current->key);
+
+    if (key < current->key) {
+        if (arena_avl_insert(&current->children[LEFT], key, value)) {
+            return arena_avl_rebalance(p_current, LEFT);
+        }
+    } else {
+        if (arena_avl_insert(&current->children[RIGHT], key, value)) {
+            return arena_avl_rebalance(p_current, RIGHT);
+        }
+    }
+    return false;
+}
+
+arena_avl_node* arena_avl_search(arena_avl_node* current, int target) {
+    while (current != NULL && target != current->key) {
+        current = current->children[target < current->key ? LEFT : RIGHT];
+    }
+    return current;
+}
+
+void arena_avl_clear(arena_avl_node** p_current) {
+    arena_avl_node* current = *p_current;
+    if (current != NULL) {
+        arena_avl_clear(&current->children[LEFT]);
+        arena_avl_clear(&current->children[RIGHT]);
+        free(current);
+        *p_current = NULL;
+    }
+}
+
+// 08/b_tree.c の、string_ref に書き換える前の node, pair と init_internal_node から insert_to_root までです。
+// 名前がぶつかるものには b_ を付けています。08/b_tree.c には無い clear を加えています。
+// また 08/b_tree.c の insert_to_root は pair を malloc したまま解放していないので、
+// ここではローカル変数にしています。
+#define M 5
+
+typedef enum {
+    INTERNAL,
+    EXTERNAL,
+} node_type;
+
+typedef struct b_node_ b_node;
+
+typedef struct {
+    b_node* ptr;
+    int bound;
+} b_pair;
+
+struct b_node_ {
+    node_type tag;
+
+    // 各インスタンスは internal か external の一方の
+    // データのみを必要とするため、無名共用体を使います。
+    union {
+        struct {
+            int count;
+            b_pair children[M];
+        } internal;
+
+        struct {
+            int key;
+            char value[32];
+        } external;
+    };
+};
+
+b_node* b_init_internal_node(int count) {
+    b_node* new_node = (b_node*)malloc(sizeof(b_node));
+    allocated_bytes += sizeof(b_node);
+    new_node->tag = INTERNAL;
+    new_node->internal.count = count;
+    return new_node;
+}
+
+b_node* b_init_external_node(int key, const char* value) {
+    b_node* new_node = (b_node*)malloc(sizeof(b_node));
+    allocated_bytes += sizeof(b_node);
+    new_node->tag = EXTERNAL;
+    new_node->external.key = key;
+    strcpy(new_node->external.value, value);
+    return new_node;
+}
+
+int b_locate(b_node* n, int target) {
+    int low = 1;
+    int high = n->internal.count - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (target < n->internal.children[middle].bound) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return high;
+}
+
+// target が見つかった場合はその b_node へのポインタを返し、
+// 見つからなかった場合は NULL を返します。
+b_node* b_search(b_node* root, int target) {
+    if (root == NULL) {
+        return NULL;
+    }
+
+    b_node* current = root;
+    while (current->tag == INTERNAL) {
+        int index = b_locate(current, target);
+        current = current->internal.children[index].ptr;
+    }
+    if (current->external.key == target) {
+        return current;
+    }
+    return NULL;
+}
+
+// ノードを挿入するための再帰関数です。
+// 親ノードに対して新たに子ノードを追加する必要があるかどうかを返します。
+// p_secondary: 関数内から親ノードに対して新たに挿入を依頼するためのノード情報
+bool b_insert(b_node** p_current, int key, const char* value, b_pair** p_secondary) {
+    b_node* current = *p_current;
+    b_pair* secondary = *p_secondary;
+    if (current->tag == EXTERNAL) {
+        assert(current->external.key != key);
+
+        b_node* new_node = b_init_external_node(key, value);
+        if (key < current->external.key) {
+            // swap current and new_node
+            new_node->external.key = current->external.key;
+            current->external.key = key;
+            strcpy(new_node->external.value, current->external.value);
+            strcpy(current->external.value, value);
+        }
+
+        secondary->ptr = new_node;
+        secondary->bound = new_node->external.key;
+        return true;
+    }
+
+    // これ以降は current は内点です。
+    int index = b_locate(current, key);
+    b_node* child = current->internal.children[index].ptr;
+    bool expanded = b_insert(&child, key, value, p_secondary);
+    if (!expanded) {
+        // このノードに対して新しい頂点を追加しなかったのであれば終了します。
+        return false;
+    }
+
+    // まだ子ノードを入れられる場合は、そのまま入れて終了します。
+    if (current->internal.count < M) {
+        // insert: 4
+        // before: [1][3][5][7][ ]
+        // after:  [1][3][4][5][7]
+        //               ^^^ added
+
+        for (int j = current->internal.count - 1; j >= index + 1; j--) {
+            current->internal.children[j + 1] = current->internal.children[j];
+        }
+        current->internal.children[index + 1] = *secondary;
+        current->internal.count++;
+        return false;
+    }
+
+    // これ以降は、もう子ノードを入れられない場合です。
+    // これ以上追加できないため、ノードを分割します。
+    // 分割してノードの半数を移動するための新しい内点を作成します。
+    b_node* new_node = b_init_internal_node(0);
+
+    int split_index = (M + 1) / 2 - 1;
+    if (index >= split_index) {
+        // ノードを追加したい箇所が split_index 以上であれば、
+        // 分割して新しく作った方の内点に追加します。
+        // insert 6 (index=2)
+        // before: [1][3][5][7][9]
+        // after1: [1][3][5][ ]  [7][9][ ][ ]
+        //                       ^^^^^^^^^^^^ new internal b_node
+        // after2: [1][3][5][ ]  [6][7][9][ ]
+        //                       ^^^ added
+
+        int new_index = 0;
+        for (int j = split_index + 1; j <= index; j++) {
+            new_node->internal.children[new_index++] = current->internal.children[j];
+        }
+        new_node->internal.children[new_index++] = *secondary;
+        for (int j = index + 1; j < M; j++) {
+            new_node->internal.children[new_index++] = current->internal.children[j];
+        }
+    } else {  // index < split_index
+        // ノードを追加したい箇所が split_index 未満であれば、
+        // 分割して残った方の内点に追加します。
+        // insert 2 (index=0)
+        // before: [1][3][5][7][9]
+        // after1: [1][3][ ][ ]  [5][7][9][ ]
+        //                       ^^^^^^^^^^^^ new internal b_node
+        // after2: [1][2][3][ ]  [5][7][9][ ]
+        //            ^^^ added
+
+        // new_node に子ノードの半分を移動させます。
+        int new_index = 0;
+        for (int j = split_index; j < M; j++) {
+            new_node->internal.children[new_index++] = current->internal.children[j];
+        }
+
+        // current に新しい子ノードを追加します。
+        for (int j = split_index - 1; j >= index + 1; j--) {
+            current->internal.children[j + 1] = current->internal.children[j];
+        }
+        current->internal.children[index + 1] = *secondary;
+    }
+    current->internal.count = split_index + 1;
+    new_node->internal.count = M - split_index;
+    secondary->ptr = new_node;
+    secondary->bound = new_node->internal.children[0].bound;
+    return true;
+}
+
+void b_insert_to_root(b_node** p_root, int key, const char* value) {
+    if (*p_root == NULL) {
+        *p_root = b_init_external_node(key, value);
+        return;
+    }
+
+    b_pair secondary_pair;
+    b_pair* secondary = &secondary_pair;
+    if (b_insert(p_root, key, value, &secondary)) {
+        b_node* new_root = b_init_internal_node(2);
+        new_root->internal.children[0].ptr = *p_root;
+        new_root->internal.children[1] = *secondary;
+        *p_root = new_root;
+    }
+}
+
+void b_clear(b_node* current) {
+    if (current == NULL) {
+        return;
+    }
+    if (current->tag == INTERNAL) {
+        for (int i = 0; i < current->internal.count; i++) {
+            b_clear(current->internal.children[i].ptr);
+        }
+    }
+    free(current);
+}
+
+// value を arena に置いた B 木の node です。
+// node は internal と external の共用体なので、sizeof は大きい方の internal で決まり、
+// value を string_ref にしても node は小さくなりません。
+// 31 文字より長い value を入れられることと、strcpy による書き込みが無くなることが違いです。
+typedef struct arena_b_node_ arena_b_node;
+
+typedef struct {
+    arena_b_node* ptr;
+    int bound;
+} arena_b_pair;
+
+struct arena_b_node_ {
+    node_type tag;
+
+    // 各インスタンスは internal か external の一方の
+    // データのみを必要とするため、無名共用体を使います。
+    union {
+        struct {
+            int count;
+            arena_b_pair children[M];
+        } internal;
+
+        struct {
+            int key;
+            string_ref value;
+        } external;
+    };
+};
+
+arena_b_node* arena_b_init_internal_node(int count) {
+    arena_b_node* new_node = (arena_b_node*)malloc(sizeof(arena_b_node));
+    allocated_bytes += sizeof(arena_b_node);
+    new_node->tag = INTERNAL;
+    new_node->internal.count = count;
+    return new_node;
+}
+
+arena_b_node* arena_b_init_external_node(int key, const char* value) {
+    arena_b_node* new_node = (arena_b_node*)malloc(sizeof(arena_b_node));
+    allocated_bytes += sizeof(arena_b_node);
+    new_node->tag = EXTERNAL;
+    new_node->external.key = key;
+    new_node->external.value = arena_store(&values, value);
+    return new_node;
+}
+
+int arena_b_locate(arena_b_node* n, int target) {
+    int low = 1;
+    int high = n->internal.count - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (target < n->internal.children[middle].bound) {
+            high = middle - 1;
+        } else {
+            low = middle + 1;
+        }
+    }
+    return high;
+}
+
+// target が見つかった場合はその arena_b_node へのポインタを返し、
+// 見つからなかった場合は NULL を返します。
+arena_b_node* arena_b_search(arena_b_node* root, int target) {
+    if (root == NULL) {
+        return NULL;
+    }
+
+    arena_b_node* current = root;
+    while (current->tag == INTERNAL) {
+        int index = arena_b_locate(current, target);
+        current = current->internal.children[index].ptr;
+    }
+    if (current->external.key == target) {
+        return current;
+    }
+    return NULL;
+}
+
+// ノードを挿入するための再帰関数です。
+// 親ノードに対して新たに子ノードを追加する必要があるかどうかを返します。
+// p_secondary: 関数内から親ノードに対して新たに挿入を依頼するためのノード情報
+bool arena_b_insert(arena_b_node** p_current, int key, const char* value, arena_b_pair** p_secondary) {
+    arena_b_node* current = *p_current;
+    arena_b_pair* secondary = *p_secondary;
+    if (current->tag == EXTERNAL) {
+        assert(current->external.key != key);
+
+        arena_b_node* new_node = arena_b_init_external_node(key, value);
+        if (key < current->external.key) {
+            // swap current and new_node
+            new_node->external.key = current->external.key;
+            current->external.key = key;
+            string_ref tmp = new_node->external.value;
+            new_node->external.value = current->external.value;
+            current->external.value = tmp;
+        }
+
+        secondary->ptr = new_node;
+        secondary->bound = new_node->external.key;
+        return true;
+    }
+
+    // これ以降は current は内点です。
+    int index = arena_b_locate(current, key);
+    arena_b_node* child = current->internal.children[index].ptr;
+    bool expanded = arena_b_insert(&child, key, value, p_secondary);
+    if (!expanded) {
+        // このノードに対して新しい頂点を追加しなかったのであれば終了します。
+        return false;
+    }
+
+    // まだ子ノードを入れられる場合は、そのまま入れて終了します。
+    if (current->internal.count < M) {
+        // insert: 4
+        // before: [1][3][5][7][ ]
+        // after:  [1][3][4][5][7]
+        //               ^^^ added
+
+        for (int j = current->internal.count - 1; j >= index + 1; j--) {
+            current->internal.children[j + 1] = current->internal.children[j];
+        }
+        current->internal.children[index + 1] = *secondary;
+        current->internal.count++;
+        return false;
+    }
+
+    // これ以降は、もう子ノードを入れられない場合です。
+    // これ以上追加できないため、ノードを分割します。
+    // 分割してノードの半数を移動するための新しい内点を作成します。
+    arena_b_node* new_node = arena_b_init_internal_node(0);
+
+    int split_index = (M + 1) / 2 - 1;
+    if (index >= split_index) {
+        // ノードを追加したい箇所が split_index 以上であれば、
+        // 分割して新しく作った方の内点に追加します。
+        // insert 6 (index=2)
+        // before: [1][3][5][7][9]
+        // after1: [1][3][5][ ]  [7][9][ ][ ]
+        //                       ^^^^^^^^^^^^ new internal arena_b_node
+        // after2: [1][3][5][ ]  [6][7][9][ ]
+        //                       ^^^ added
+
+        int new_index = 0;
+        for (int j = split_index + 1; j <= index; j++) {
+            new_node->internal.children[new_index++] = current->internal.children[j];
+        }
+        new_node->internal.children[new_index++] = *secondary;
+        for (int j = index + 1; j < M; j++) {
+            new_node->internal.children[new_index++] = current->internal.children[j];
+        }
+    } else {  // index < split_index
+        // ノードを追加したい箇所が split_index 未満であれば、
+        // 分割して残った方の内点に追加します。
+        // insert 2 (index=0)
+        // before: [1][3][5][7][9]
+        // after1: [1][3][ ][ ]  [5][7][9][ ]
+        //                       ^^^^^^^^^^^^ new internal arena_b_node
+        // after2: [1][2][3][ ]  [5][7][9][ ]
+        //            ^^^ added
+
+        // new_node に子ノードの半分を移動させます。
+        int new_index = 0;
+        for (int j = split_index; j < M; j++) {
+            new_node->internal.children[new_index++] = current->internal.children[j];
+        }
+
+        // current に新しい子ノードを追加します。
+        for (int j = split_index - 1; j >= index + 1; j--) {
+            current->internal.children[j + 1] = current->internal.children[j];
+        }
+        current->internal.children[index + 1] = *secondary;
+    }
+    current->internal.count = split_index + 1;
+    new_node->internal.count = M - split_index;
+    secondary->ptr = new_node;
+    secondary->bound = new_node->internal.children[0].bound;
+    return true;
+}
+
+void arena_b_insert_to_root(arena_b_node** p_root, int key, const char* value) {
+    if (*p_root == NULL) {
+        *p_root = arena_b_init_external_node(key, value);
+        return;
+    }
+
+    arena_b_pair secondary_pair;
+    arena_b_pair* secondary = &secondary_pair;
+    if (arena_b_insert(p_root, key, value, &secondary)) {
+        arena_b_node* new_root = arena_b_init_internal_node(2);
+        new_root->internal.children[0].ptr = *p_root;
+        new_root->internal.children[1] = *secondary;
+        *p_root = new_root;
+    }
+}
+
+void arena_b_clear(arena_b_node* current) {
+    if (current == NULL) {
+        return;
+    }
+    if (current->tag == INTERNAL) {
+        for (int i = 0; i < current->internal.count; i++) {
+            arena_b_clear(current->internal.children[i].ptr);
+        }
+    }
+    free(current);
+}
+
+uint64_t xorshift64(uint64_t* state) {
+    uint64_t x = *state;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    *state = x;
+    return x;
+}
+
+double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// key から長さ length の value を作ります。
+void make_value(char* buffer, int key, int length) {
+    for (int i = 0; i < length; i++) {
+        buffer[i] = 'A' + (key + i) % 26;
+    }
+    buffer[length] = '\0';
+}
+
+void shuffle(int* array, int length, uint64_t* state) {
+    for (int i = length - 1; i > 0; i--) {
+        int j = (int)(xorshift64(state) % (uint64_t)(i + 1));
+        int tmp = array[i];
+        array[i] = array[j];
+        array[j] = tmp;
+    }
+}
+
+// 計測する辞書です。build で keys を入れ、lookup で target を探し、destroy で解放します。
+// lookup は見つかった value の先頭の文字と長さの和を返すので、value も読み込みます。
+typedef struct {
+    void (*build)(int* keys, int n, int value_length);
+    long long (*lookup)(int target);
+    void (*destroy)();
+} dictionary;
+
+table tab;
+arena_table atab;
+list_table ltab;
+arena_list_table altab;
+sorted_table stab;
+arena_sorted_table astab;
+node* tree_root;
+arena_node* arena_tree_root;
+avl_node* avl_root;
+arena_avl_node* arena_avl_root;
+b_node* b_root;
+arena_b_node* arena_b_root;
+
+void build_table(int* keys, int n, int value_length) {
+    char value[32];
+    tab = (table){0, n + 1, (record*)malloc((n + 1) * sizeof(record))};
+    allocated_bytes += n * sizeof(record);
+    for (int i = 0; i < n; i++) {
+        make_value(value, keys[i], value_length);
+        insert(&tab, keys[i], value);
+    }
+}
+
+long long lookup_table(int target) {
+    record* rec = &tab.records[search(&tab, target)];
+    return rec->value[0] + (long long)strlen(rec->value);
+}
+
+void destroy_table() {
+    free(tab.records);
+}
+
+void build_arena_table(int* keys, int n, int value_length) {
+    char value[32];
+    atab = (arena_table){0, n + 1, (arena_record*)malloc((n + 1) * sizeof(arena_record))};
+    allocated_bytes += n * sizeof(arena_record);
+    for (int i = 0; i < n; i++) {
+        make_value(value, keys[i], value_length);
+        arena_insert(&atab, keys[i], value);
+    }
+}
+
+long long lookup_arena_table(int target) {
+    arena_record* rec = &atab.records[arena_search(&atab, target)];
+    return string_data(&values, &rec->value)[0] + (long long)rec->value.length;
+}
+
+void destroy_arena_table() {
+    free(atab.records);
+}
+
+// header と sentinel は record の数に含めないので、allocated_bytes から除きます。
+void build_list(int* keys, int n, int value_length) {
+    char value[32];
+    ltab.header = init_list_record(-1, "");
+    ltab.sentinel = init_list_record(-1, "");
+    ltab.header->next = ltab.sentinel;
+    allocated_bytes = 0;
+    for (int i = 0; i < n; i++) {
+        make_value(value, keys[i], value_length);
+        insert_head(&ltab, init_list_record(keys[i], value));
+    }
+}
+
+long long lookup_list(int target) {
+    list_record* rec = search_previous(&ltab, target)->next;
+    return rec->value[0] + (long long)strlen(rec->value);
+}
+
+void destroy_list() {
+    list_clear(&ltab);
+}
+
+void build_arena_list(int* keys, int n, int value_length) {
+    char value[32];
+    altab.header = init_arena_list_record(-1, "");
+    altab.sentinel = init_arena_list_record(-1, "");
+    altab.header->next = altab.sentinel;
+    allocated_bytes = 0;
+    for (int i = 0; i < n; i++) {
+        make_value(value, keys[i], value_length);
+        arena_insert_head(&altab, init_arena_list_record(keys[i], value));
+    }
+}
+
+long long lookup_arena_list(int target) {
+    arena_list_record* rec = arena_search_previous(&altab, target)->next;
+    return string_data(&values, &rec->value)[0] + (long long)rec->value.length;
+}
+
+void destroy_arena_list() {
+    arena_list_clear(&altab);
+}
+
+// 順序を保つ表にランダムな順で insert すると、1 回ごとに平均 n / 2 個の record をずらすことになります。
+// ここでは record の大きさだけを比べたいので、key の小さい順に insert して、ずらす record を無くします。
+// value は key だけから作るので、keys の順番によらず同じ表になります。
+void build_sorted_table(int* keys, int n, int value_length) {
+    (void)keys;
+    stab = (sorted_table){0, n, (sorted_record*)malloc(n * sizeof(sorted_record))};
+    allocated_bytes += n * sizeof(sorted_record);
+    for (int key = 0; key < n; key++) {
+        sorted_record rec = {key, ""};
+        make_value(rec.value, key, value_length);
+        sorted_insert(&stab, rec);
+    }
+}
+
+long long lookup_sorted_table(int target) {
+    sorted_record* rec = &stab.records[sorted_search(&stab, target)];
+    return rec->value[0] + (long long)strlen(rec->value);
+}
+
+void destroy_sorted_table() {
+    free(stab.records);
+}
+
+void build_arena_sorted_table(int* keys, int n, int value_length) {
+    (void)keys;
+    char value[32];
+    astab = (arena_sorted_table){0, n, (arena_sorted_record*)malloc(n * sizeof(arena_sorted_record))};
+    allocated_bytes += n * sizeof(arena_sorted_record);
+    for (int key = 0; key < n; key++) {
+        make_value(value, key, value_length);
+        arena_sorted_record rec = {key, arena_store(&values, value)};
+        arena_sorted_insert(&astab, rec);
+    }
+}
+
+long long lookup_arena_sorted_table(int target) {
+    arena_sorted_record* rec = &astab.records[arena_sorted_search(&astab, target)];
+    return string_data(&values, &rec->value)[0] + (long long)rec->value.length;
+}
+
+void destroy_arena_sorted_table() {
+    free(astab.records);
+}
+
+void build_tree(int* keys, int n, int value_length) {
+    char value[32];
+    for (int i = 0; i < n; i++) {
+        make_value(value, keys[i], value_length);
+        tree_insert(&tree_root, keys[i], value);
+    }
+}
+
+long long lookup_tree(int target) {
+    node* n = tree_search(tree_root, target);
+    return n->value[0] + (long long)strlen(n->value);
+}
+
+void destroy_tree() {
+    clear(&tree_root);
+}
+
+void build_arena_tree(int* keys, int n, int value_length) {
+    char value[32];
+    for (int i = 0; i < n; i++) {
+        make_value(value, keys[i], value_length);
+        arena_tree_insert(&arena_tree_root, keys[i], value);
+    }
+}
+
+long long lookup_arena_tree(int target) {
+    arena_node* n = arena_tree_search(arena_tree_root, target);
+    return string_data(&values, &n->value)[0] + (long long)n->value.length;
+}
+
+void destroy_arena_tree() {
+    arena_tree_clear(&arena_tree_root);
+}
+
+void build_avl(int* keys, int n, int value_length) {
+    char value[32];
+    for (int i = 0; i < n; i++) {
+        make_value(value, keys[i], value_length);
+        avl_insert(&avl_root, keys[i], value);
+    }
+}
+
+long long lookup_avl(int target) {
+    avl_node* n = avl_search(avl_root, target);
+    return n->value[0] + (long long)strlen(n->value);
+}
+
+void destroy_avl() {
+    avl_clear(&avl_root);
+}
+
+void build_arena_avl(int* keys, int n, int value_length) {
+    char value[32];
+    for (int i = 0; i < n; i++) {
+        make_value(value, keys[i], value_length);
+        arena_avl_insert(&arena_avl_root, keys[i], value);
+    }
+}
+
+long long lookup_arena_avl(int target) {
+    arena_avl_node* n = arena_avl_search(arena_avl_root, target);
+    return string_data(&values, &n->value)[0] + (long long)n->value.length;
+}
+
+void destroy_arena_avl() {
+    arena_avl_clear(&arena_avl_root);
+}
+
+void build_b_tree(int* keys, int n, int value_length) {
+    char value[32];
+    for (int i = 0; i < n; i++) {
+        make_value(value, keys[i], value_length);
+        b_insert_to_root(&b_root, keys[i], value);
+    }
+}
+
+long long lookup_b_tree(int target) {
+    b_node* n = b_search(b_root, target);
+    return n->external.value[0] + (long long)strlen(n->external.value);
+}
+
+void destroy_b_tree() {
+    b_clear(b_root);
+    b_root = NULL;
+}
+
+void build_arena_b_tree(int* keys, int n, int value_length) {
+    char value[32];
+    for (int i = 0; i < n; i++) {
+        make_value(value, keys[i], value_length);
+        arena_b_insert_to_root(&arena_b_root, keys[i], value);
+    }
+}
+
+long long lookup_arena_b_tree(int target) {
+    arena_b_node* n = arena_b_search(arena_b_root, target);
+    return string_data(&values, &n->external.value)[0] + (long long)n->external.value.length;
+}
+
+void destroy_arena_b_tree() {
+    arena_b_clear(arena_b_root);
+    arena_b_root = NULL;
+}
+
+typedef struct {
+    double bytes_per_record;
+    double ns;
+    long long checksum;
+} result;
+
+// bytes/record は確保した record (node) の大きさと arena の使用量の合計を record の数で割ったものです。
+// node を malloc で確保する場合は、これに malloc の管理領域が加わります。
+result benchmark(dictionary* d, int* keys, int n, int* targets, int num_lookups, int value_length) {
+    allocated_bytes = 0;
+    arena_reset(&values);
+    d->build(keys, n, value_length);
+    result r = {(double)(allocated_bytes + values.used) / n, 0, 0};
+
+    double start = now();
+    for (int q = 0; q < num_lookups; q++) {
+        r.checksum += d->lookup(targets[q]);
+    }
+    r.ns = (now() - start) * 1e9 / num_lookups;
+    d->destroy();
+    return r;
+}
+
+int main() {
+    arena_init(&values, 1024);
+
+    // 短い value は string_ref の中に、長い value は arena に入ります。
+    // 32 文字以上の value も入れられます。
+    arena_node* root = NULL;
+    arena_tree_insert(&root, 4, "DDD");
+    arena_tree_insert(&root, 2, "BBBBBBBB");
+    arena_tree_insert(&root, 6, "FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF");
+    arena_tree_insert(&root, 1, "A");
+    arena_tree_insert(&root, 3, "");
+    printf("TREE:\n");
+    arena_tree_print(root, 0);
+    printf("arena used = %u bytes\n", values.used);
+    arena_tree_clear(&root);
+
+    printf("\n%-24s %10s %10s\n", "record / node", "char[32]", "string_ref");
+    printf("%-24s %10zu %10zu\n", "05 array table record", sizeof(record), sizeof(arena_record));
+    printf("%-24s %10zu %10zu\n", "05 list record", sizeof(list_record), sizeof(arena_list_record));
+    printf("%-24s %10zu %10zu\n", "06 sorted table record", sizeof(sorted_record), sizeof(arena_sorted_record));
+    printf("%-24s %10zu %10zu\n", "06 binary tree node", sizeof(node), sizeof(arena_node));
+    printf("%-24s %10zu %10zu\n", "07 AVL tree node", sizeof(avl_node), sizeof(arena_avl_node));
+    printf("%-24s %10zu %10zu\n", "08 B-tree node", sizeof(b_node), sizeof(arena_b_node));
+
+    const char* names[] = {"05 array table", "05 list", "06 sorted table", "06 binary tree", "07 AVL tree",
+                           "08 B-tree"};
+    int sizes[] = {NUM_TABLE_RECORDS, NUM_LIST_RECORDS, NUM_SORTED_RECORDS, NUM_TREE_NODES, NUM_TREE_NODES,
+                   NUM_TREE_NODES};
+    int num_lookups[] = {NUM_TABLE_LOOKUPS, NUM_LIST_LOOKUPS, NUM_SORTED_LOOKUPS, NUM_TREE_LOOKUPS,
+                         NUM_TREE_LOOKUPS, NUM_TREE_LOOKUPS};
+    dictionary fixed[] = {
+        {build_table, lookup_table, destroy_table},
+        {build_list, lookup_list, destroy_list},
+        {build_sorted_table, lookup_sorted_table, destroy_sorted_table},
+        {build_tree, lookup_tree, destroy_tree},
+        {build_avl, lookup_avl, destroy_avl},
+        {build_b_tree, lookup_b_tree, destroy_b_tree},
+    };
+    dictionary arena[] = {
+        {build_arena_table, lookup_arena_table, destroy_arena_table},
+        {build_arena_list, lookup_arena_list, destroy_arena_list},
+        {build_arena_sorted_table, lookup_arena_sorted_table, destroy_arena_sorted_table},
+        {build_arena_tree, lookup_arena_tree, destroy_arena_tree},
+        {build_arena_avl, lookup_arena_avl, destroy_arena_avl},
+        {build_arena_b_tree, lookup_arena_b_tree, destroy_arena_b_tree},
+    };
+
+    int num_dictionaries = sizeof(fixed) / sizeof(fixed[0]);
+
+    uint64_t state = 88172645463325252ULL;
+    int max_records = 0;
+    int max_lookups = 0;
+    for (int d = 0; d < num_dictionaries; d++) {
+        max_records = sizes[d] > max_records ? sizes[d] : max_records;
+        max_lookups = num_lookups[d] > max_lookups ? num_lookups[d] : max_lookups;
+    }
+    int* keys = (int*)malloc(max_records * sizeof(int));
+    int* targets = (int*)malloc(max_lookups * sizeof(int));
+    printf("\n%-16s %8s %6s %10s %10s %12s %12s\n", "dictionary", "records", "value", "bytes/rec", "bytes/rec",
+           "lookup ns", "lookup ns");
+    printf("%-16s %8s %6s %10s %10s %12s %12s\n", "", "", "length", "char[32]", "arena", "char[32]", "arena");
+    int value_lengths[] = {3, 16, 31};
+    for (int d = 0; d < num_dictionaries; d++) {
+        for (int v = 0; v < 3; v++) {
+            for (int i = 0; i < sizes[d]; i++) {
+                keys[i] = i;
+            }
+            shuffle(keys, sizes[d], &state);
+            for (int q = 0; q < num_lookups[d]; q++) {
+                targets[q] = (int)(xorshift64(&state) % (uint64_t)sizes[d]);
+            }
+            result before = benchmark(&fixed[d], keys, sizes[d], targets, num_lookups[d], value_lengths[v]);
+            result after = benchmark(&arena[d], keys, sizes[d], targets, num_lookups[d], value_lengths[v]);
+            assert(before.checksum == after.checksum);
+            printf("%-16s %8d %6d %10.1lf %10.1lf %12.1lf %12.1lf\n", names[d], sizes[d], value_lengths[v],
+                   before.bytes_per_record, after.bytes_per_record, before.ns, after.ns);
+        }
+    }
+
+    free(keys);
+    free(targets);
+    arena_clear(&values);
+    return 0;
+}
+
+// 実行結果 (gcc -O2)
+// TREE:
+//   {6, FFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFFF}
+// {4, DDD}
+//     {3, }
+//   {2, BBBBBBBB}
+//     {1, A}
+// arena used = 48 bytes
+//
+// record / node              char[32] string_ref
+// 05 array table record            36         12
+// 05 list record                   48         24
+// 06 sorted table record           36         12
+// 06 binary tree node              56         32
+// 07 AVL tree node                 64         40
+// 08 B-tree node                   96         96
+//
+// dictionary        records  value  bytes/rec  bytes/rec    lookup ns    lookup ns
+//                           length   char[32]      arena     char[32]        arena
+// 05 array table    1000000      3       36.0       12.0     849298.8     294281.3
+// 05 array table    1000000     16       36.0       28.0     835026.8     360858.6
+// 05 array table    1000000     31       36.0       43.0     772612.9     269718.9
+// 05 list            100000      3       48.0       24.0     145052.1      96036.3
+// 05 list            100000     16       48.0       40.0     278108.8     197644.7
+// 05 list            100000     31       48.0       55.0     188265.0     124165.2
+// 06 sorted table   1000000      3       36.0       12.0        343.7        286.6
+// 06 sorted table   1000000     16       36.0       28.0        410.7        328.3
+// 06 sorted table   1000000     31       36.0       43.0        354.8        332.4
+// 06 binary tree    1000000      3       56.0       32.0        870.8        735.6
+// 06 binary tree    1000000     16       56.0       48.0        901.0        624.0
+// 06 binary tree    1000000     31       56.0       63.0        938.2        900.2
+// 07 AVL tree       1000000      3       64.0       40.0       1290.9        885.1
+// 07 AVL tree       1000000     16       64.0       56.0       1289.4       1042.4
+// 07 AVL tree       1000000     31       64.0       71.0       1626.6       1041.3
+// 08 B-tree         1000000      3      131.5      131.5       1422.4       1413.1
+// 08 B-tree         1000000     16      131.4      147.4       1558.6       1487.3
+// 08 B-tree         1000000     31      131.5      162.5       1425.8       1280.2
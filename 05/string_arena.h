@@ -0,0 +1,92 @@
+#ifndef STRING_ARENA_H
+#define STRING_ARENA_H
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// 辞書の value を置く文字列の arena です。05/string_arena.c で説明と計測をしています。
+// 05 から 08 の辞書は、このファイルを相対パスで include して使います。
+
+// 文字列の長さと、arena の中での位置 (offset) です。
+// length が STRING_INLINE_MAX 以下の場合は、offset の代わりに chars に文字列そのものを入れます。
+// いずれの場合も終端の '\0' は持たないので、長さは length で調べます。
+#define STRING_INLINE_MAX 4
+
+typedef struct {
+    uint32_t length;
+    union {
+        uint32_t offset;
+        char chars[STRING_INLINE_MAX];
+    };
+} string_ref;
+
+// 文字列を先頭から順に詰めていく領域です。足りなくなったら realloc で倍に広げます。
+// 場所が変わっても offset は変わらないので、record に入れた string_ref はそのまま使えます。
+// 個々の文字列は解放せず、arena_reset や arena_clear でまとめて解放します。
+// そのため erase された record の文字列は、まとめて解放するまで arena に残ります。
+typedef struct {
+    char* data;
+    uint32_t used;
+    uint32_t capacity;
+} string_arena;
+
+void arena_init(string_arena* arena, uint32_t capacity) {
+    arena->data = (char*)malloc(capacity);
+    arena->used = 0;
+    arena->capacity = arena->data != NULL ? capacity : 0;
+}
+
+// 入っている文字列をすべて捨てます。確保した領域はそのまま使い回します。
+void arena_reset(string_arena* arena) {
+    arena->used = 0;
+}
+
+void arena_clear(string_arena* arena) {
+    free(arena->data);
+    arena->data = NULL;
+    arena->used = 0;
+    arena->capacity = 0;
+}
+
+string_ref arena_store(string_arena* arena, const char* s) {
+    size_t length = strlen(s);
+    assert(length <= UINT32_MAX - arena->used);
+
+    string_ref ref;
+    ref.length = (uint32_t)length;
+    if (length <= STRING_INLINE_MAX) {
+        memcpy(ref.chars, s, length);
+        return ref;
+    }
+
+    if (arena->used + length > arena->capacity) {
+        uint32_t capacity = arena->capacity > 0 ? arena->capacity : 64;
+        while (arena->used + length > capacity) {
+            capacity = capacity <= UINT32_MAX / 2 ? capacity * 2 : UINT32_MAX;
+        }
+        char* data = (char*)realloc(arena->data, capacity);
+        if (data == NULL) {
+            fprintf(stderr, "arena_store: failed to allocate %u bytes\n", capacity);
+            exit(1);
+        }
+        arena->data = data;
+        arena->capacity = capacity;
+    }
+    ref.offset = arena->used;
+    memcpy(arena->data + arena->used, s, length);
+    arena->used += (uint32_t)length;
+    return ref;
+}
+
+// 文字列の先頭へのポインタを返します。
+// 終端の '\0' は無いので、ref->length 文字だけを読んでください (printf では "%.*s" を使います)。
+// strlen を使う arena_store などにそのまま渡すと、文字列の終わりを越えて読んでしまいます。
+// また arena_store で arena が広がると無効になるので、すぐに使ってください。
+const char* string_data(const string_arena* arena, const string_ref* ref) {
+    return ref->length <= STRING_INLINE_MAX ? ref->chars : arena->data + ref->offset;
+}
+
+#endif
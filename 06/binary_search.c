@@ -4,11 +4,16 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../05/string_arena.h"
+
 #define MAX_NUM_RECORDS 1000
 
+// value は char value[32] ではなく string_ref で持ち、文字列そのものはこの arena に置きます。
+string_arena values;
+
 typedef struct {
     int key;
-    char value[32];
+    string_ref value;
 } record;
 
 typedef struct {
@@ -51,6 +56,7 @@ void insert(table* tab, record rec) {
     tab->length++;
 }
 
+// value の文字列は arena に残り、最後の arena_clear でまとめて解放されます。
 void erase(table* tab, int pos) {
     // before: [0 1 2 3 4 5]
     // erase: 3 (index = 3)
@@ -64,7 +70,8 @@ void erase(table* tab, int pos) {
 void print(table* tab) {
     printf("[ ");
     for (int i = 0; i < tab->length; i++) {
-        printf("{%d, %s} ", tab->records[i].key, tab->records[i].value);
+        record* rec = &tab->records[i];
+        printf("{%d, %.*s} ", rec->key, (int)rec->value.length, string_data(&values, &rec->value));
     }
     printf("]\n");
 }
@@ -91,7 +98,7 @@ int main() {
 
     table tab = {0};
     for (int i = 0; i < num_keys; i++) {
-        record rec = {keys[i], "AAA"};
+        record rec = {keys[i], arena_store(&values, "AAA")};
         insert(&tab, rec);
     }
     print(&tab);
@@ -100,7 +107,8 @@ int main() {
     int target = 3;
     int index = search(&tab, target);
     if (index != -1 && tab.records[index].key == target) {
-        printf("%d was %s\n", target, tab.records[index].value);
+        string_ref* value = &tab.records[index].value;
+        printf("%d was %.*s\n", target, (int)value->length, string_data(&values, value));
     } else {
         printf("%d was NOT FOUND.\n", target);
     }
@@ -113,11 +121,13 @@ int main() {
     // search 3
     index = search(&tab, target);
     if (index != -1 && tab.records[index].key == target) {
-        printf("%d was %s\n", target, tab.records[index].value);
+        string_ref* value = &tab.records[index].value;
+        printf("%d was %.*s\n", target, (int)value->length, string_data(&values, value));
     } else {
         printf("%d was NOT FOUND.\n", target);
     }
 
+    arena_clear(&values);
     return 0;
 }
 
@@ -1,11 +1,17 @@
 #include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "../05/string_arena.h"
+
+// value は char value[32] ではなく string_ref で持ち、文字列そのものはこの arena に置きます。
+string_arena values;
+
 typedef struct node_ {
     int key;
-    char value[32];
+    string_ref value;
     struct node_* left;
     struct node_* right;
 } node;
@@ -15,7 +21,7 @@ node* init_node(int key, const char* value) {
     n->key = key;
     n->left = NULL;
     n->right = NULL;
-    strcpy(n->value, value);
+    n->value = arena_store(&values, value);
     return n;
 }
 
@@ -106,7 +112,7 @@ void print(node* current, int depth) {
     for (int i = 0; i < depth; i++) {
         printf("  ");
     }
-    printf("{%d, %s}\n", current->key, current->value);
+    printf("{%d, %.*s}\n", current->key, (int)current->value.length, string_data(&values, &current->value));
 
     // left
     print(current->left, depth + 1);
@@ -144,7 +150,7 @@ int main() {
     int target = 8;
     node* result = search(root, target);
     if (result != NULL) {
-        printf("%d is %s\n", target, result->value);
+        printf("%d is %.*s\n", target, (int)result->value.length, string_data(&values, &result->value));
     } else {
         printf("%d is not found\n", target);
     }
@@ -158,12 +164,13 @@ int main() {
     // search target
     result = search(root, target);
     if (result != NULL) {
-        printf("%d is %s\n", target, result->value);
+        printf("%d is %.*s\n", target, (int)result->value.length, string_data(&values, &result->value));
     } else {
         printf("%d is not found\n", target);
     }
 
     clear(&root);
+    arena_clear(&values);
     return 0;
 }
 
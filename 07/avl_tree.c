@@ -1,9 +1,15 @@
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "../05/string_arena.h"
+
+// value は char value[32] ではなく string_ref で持ち、文字列そのものはこの arena に置きます。
+string_arena values;
+
 typedef enum {
     LEFT,
     RIGHT,
@@ -12,7 +18,7 @@ typedef enum {
 
 typedef struct node_ {
     int key;
-    char value[32];
+    string_ref value;
     struct node_* children[2];
     direction balance;
 } node;
@@ -68,6 +74,7 @@ bool rebalance(node** p, direction inserted_dir) {
         } else {
             a->balance = opposite_dir;
         }
+        c->balance = BALANCED;
         *p = c;  // Cを上に持ち上げる
         return false;
     }
@@ -87,7 +94,7 @@ bool insert(node** p_current, int key, const char* value) {
         n->children[LEFT] = NULL;
         n->children[RIGHT] = NULL;
         n->balance = BALANCED;
-        strcpy(n->value, value);
+        n->value = arena_store(&values, value);
         *p_current = n;
         return true;
     }
@@ -119,7 +126,7 @@ void print(node* current, int depth) {
     for (int i = 0; i < depth; i++) {
         printf("  ");
     }
-    printf("{%d, %s}\n", current->key, current->value);
+    printf("{%d, %.*s}\n", current->key, (int)current->value.length, string_data(&values, &current->value));
 
     // left
     print(current->children[LEFT], depth + 1);
@@ -145,6 +152,8 @@ int main() {
     insert(&root, 7, "7");  // case 3b
     printf("TREE:\n");
     print(root, 1);
+
+    arena_clear(&values);
 }
 
 // 実行結果
@@ -1,9 +1,15 @@
 #include <assert.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "../05/string_arena.h"
+
+// value は char value[32] ではなく string_ref で持ち、文字列そのものはこの arena に置きます。
+string_arena values;
+
 #define M 5
 
 typedef enum {
@@ -31,7 +37,7 @@ struct node_ {
 
         struct {
             int key;
-            char value[32];
+            string_ref value;
         } external;
     };
 };
@@ -47,7 +53,7 @@ node* init_external_node(int key, const char* value) {
     node* new_node = (node*)malloc(sizeof(node));
     new_node->tag = EXTERNAL;
     new_node->external.key = key;
-    strcpy(new_node->external.value, value);
+    new_node->external.value = arena_store(&values, value);
     return new_node;
 }
 
@@ -97,8 +103,9 @@ bool insert(node** p_current, int key, const char* value, pair** p_secondary) {
             // swap current and new_node
             new_node->external.key = current->external.key;
             current->external.key = key;
-            strcpy(new_node->external.value, current->external.value);
-            strcpy(current->external.value, value);
+            string_ref tmp = new_node->external.value;
+            new_node->external.value = current->external.value;
+            current->external.value = tmp;
         }
 
         secondary->ptr = new_node;
@@ -218,7 +225,8 @@ void print(node* current, int depth) {
             print(current->internal.children[i].ptr, depth + 1);
         }
     } else {
-        printf("{%d, %s}\n", current->external.key, current->external.value);
+        printf("{%d, %.*s}\n", current->external.key, (int)current->external.value.length,
+               string_data(&values, &current->external.value));
     }
 }
 
@@ -254,10 +262,13 @@ int main() {
     int target = 8;
     node* result = search(root, target);
     if (result) {
-        printf("%d was %s\n", target, result->external.value);
+        printf("%d was %.*s\n", target, (int)result->external.value.length,
+               string_data(&values, &result->external.value));
     } else {
         printf("%d was not found\n", target);
     }
+
+    arena_clear(&values);
 }
 
 // 実行結果